@@ -0,0 +1,36 @@
+#include <QGuiApplication>
+#include <QQmlApplicationEngine>
+#include <QQmlContext>
+
+// 10000 single box models spread around the viewer, most of them behind it
+// or off to the side. Compare the draw calls and frame times with and
+// without culling:
+//
+//   QUICKVR_BACKEND=sim QUICKVR_SIM_FRAMES=600 ./CullingBenchmark
+//   QUICKVR_BACKEND=sim QUICKVR_SIM_FRAMES=600 ./CullingBenchmark --no-culling
+//
+// --dynamic makes every model dynamic, which culls them one by one instead
+// of through the BVH. --foveation shades the periphery at a lower rate,
+// compare the samples shaded per frame printed at the end.
+int main(int argc, char *argv[])
+{
+    QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+
+    QGuiApplication app(argc, argv);
+
+    const QStringList args = app.arguments();
+
+    QQmlApplicationEngine engine;
+    engine.rootContext()->setContextProperty("benchmarkCulling", !args.contains("--no-culling"));
+    engine.rootContext()->setContextProperty("benchmarkDynamic", args.contains("--dynamic"));
+    engine.rootContext()->setContextProperty("benchmarkFoveation", args.contains("--foveation"));
+
+    // This line is only necessary for QuickVR examples. Once QuickVR is
+    // deployed/installed on your system, the application sould not have any
+    // trouble finding QuickVR/quickvrplugin.dll or QuickVR/libquickvrplugin.so
+    engine.addImportPath(app.applicationDirPath() + "/../../../src/imports");
+
+    engine.load("qrc:/main.qml");
+
+    return app.exec();
+}
@@ -0,0 +1,52 @@
+import QtQuick 2.15
+import QuickVR 1.0
+
+VRWindow {
+    visible: true
+    width: 640
+    height: 480
+    title: qsTr("CullingBenchmark")
+    color: "black"
+    frustumCulling: benchmarkCulling
+    foveation: benchmarkFoveation
+
+    VRMaterial { id: blankMaterial; pattern: VRMaterial.Blank }
+
+    // A 100 x 100 grid of boxes, 2 m apart, centered on the viewer. Each one
+    // is its own model so each one is culled and drawn on its own.
+    Repeater {
+        model: 10000
+
+        VRModel {
+            readonly property int column: index % 100
+            readonly property int row: Math.floor(index / 100)
+
+            dynamic: benchmarkDynamic
+            instanced: !benchmarkDynamic
+            position: Qt.vector3d(2 * column - 100, 0, 2 * row - 100)
+            material: blankMaterial
+            VRBox { from: Qt.vector3d(0, 0, 0); to: Qt.vector3d(0.5, 0.5 + (index % 7) * 0.25, 0.5); color: "#606060" }
+        }
+    }
+
+    VRStats {
+        id: stats
+    }
+
+    Text {
+        x: 8
+        y: 8
+        color: stats.overBudgetRatio > 0.01 ? "red" : "white"
+        font.family: "monospace"
+        text: "cpu p50 %1 p95 %2 p99 %3 ms\ngpu p50 %4 p95 %5 p99 %6 ms\n%7 draws, %8 culled"
+                .arg(stats.cpuP50.toFixed(2)).arg(stats.cpuP95.toFixed(2)).arg(stats.cpuP99.toFixed(2))
+                .arg(stats.gpuP50.toFixed(2)).arg(stats.gpuP95.toFixed(2)).arg(stats.gpuP99.toFixed(2))
+                .arg(stats.drawCalls).arg(stats.culledModels)
+    }
+
+    VRHeadset {
+        x: 0
+        y: 0
+        z: 0
+    }
+}
@@ -0,0 +1,87 @@
+import QtQuick 2.15
+import QuickVR 1.0
+
+// The OculusRoomTiny room, declared with QuickVR models.
+Item {
+    VRMaterial { id: floorMaterial;   pattern: VRMaterial.Floor }
+    VRMaterial { id: wallMaterial;    pattern: VRMaterial.Wall }
+    VRMaterial { id: ceilingMaterial; pattern: VRMaterial.Ceiling }
+    VRMaterial { id: blankMaterial;   pattern: VRMaterial.Blank }
+
+    // Moving box
+    VRModel {
+        property real angle: 0
+        NumberAnimation on angle { from: 0; to: 2 * Math.PI; duration: 4650; loops: Animation.Infinite }
+
+        dynamic: true
+        position: Qt.vector3d(9 * Math.sin(angle), 3, 9 * Math.cos(angle))
+        material: ceilingMaterial
+        VRBox { from: Qt.vector3d(0, 0, 0); to: Qt.vector3d(1, 1, 1); color: "#404040" }
+    }
+
+    // Walls
+    VRModel {
+        material: wallMaterial
+        VRBox { from: Qt.vector3d(-10.1,  0.0, -20.0); to: Qt.vector3d(-10.0, 4.0,  20.0); color: "#808080" } // Left Wall
+        VRBox { from: Qt.vector3d(-10.0, -0.1, -20.1); to: Qt.vector3d( 10.0, 4.0, -20.0); color: "#808080" } // Back Wall
+        VRBox { from: Qt.vector3d( 10.0, -0.1, -20.0); to: Qt.vector3d( 10.1, 4.0,  20.0); color: "#808080" } // Right Wall
+    }
+
+    // Floors
+    VRModel {
+        material: floorMaterial
+        VRBox { from: Qt.vector3d(-10.0, -0.1, -20.0); to: Qt.vector3d(10.0,  0.0, 20.1); color: "#808080" } // Main floor
+        VRBox { from: Qt.vector3d(-15.0, -6.1,  18.0); to: Qt.vector3d(15.0, -6.0, 30.0); color: "#808080" } // Bottom floor
+    }
+
+    // Ceiling
+    VRModel {
+        material: ceilingMaterial
+        VRBox { from: Qt.vector3d(-10.0, 4.0, -20.0); to: Qt.vector3d(10.0, 4.1, 20.1); color: "#808080" }
+    }
+
+    // Fixtures & furniture
+    VRModel {
+        material: blankMaterial
+
+        VRBox { from: Qt.vector3d(9.5,  0.75, 3.0);  to: Qt.vector3d(10.1, 2.5,  3.1);  color: "#383838" } // Right side shelf verticals
+        VRBox { from: Qt.vector3d(9.5,  0.95, 3.7);  to: Qt.vector3d(10.1, 2.75, 3.8);  color: "#383838" }
+        VRBox { from: Qt.vector3d(9.55, 1.20, 2.5);  to: Qt.vector3d(10.1, 1.30, 3.75); color: "#383838" } // Right side shelf horizontals
+        VRBox { from: Qt.vector3d(9.55, 2.00, 3.05); to: Qt.vector3d(10.1, 2.10, 4.2);  color: "#383838" }
+        VRBox { from: Qt.vector3d(  5.0, 1.1, 20.0); to: Qt.vector3d(10.0, 1.2, 20.1); color: "#383838" } // Right railing
+        VRBox { from: Qt.vector3d(-10.0, 1.1, 20.0); to: Qt.vector3d(-5.0, 1.2, 20.1); color: "#383838" } // Left railing
+
+        Repeater {
+            model: 5
+            VRBox { from: Qt.vector3d(5 + index, 0.0, 20.0); to: Qt.vector3d(5.1 + index, 1.1, 20.1); color: "#505050" } // Left bars
+        }
+        Repeater {
+            model: 5
+            VRBox { from: Qt.vector3d(-5 - index, 1.1, 20.0); to: Qt.vector3d(-5.1 - index, 0.0, 20.1); color: "#505050" } // Right bars
+        }
+
+        VRBox { from: Qt.vector3d(-1.8, 0.8, 1.0); to: Qt.vector3d( 0.0, 0.7, 0.0); color: "#505000" } // Table
+        VRBox { from: Qt.vector3d(-1.8, 0.0, 0.0); to: Qt.vector3d(-1.7, 0.7, 0.1); color: "#505000" } // Table legs
+        VRBox { from: Qt.vector3d(-1.8, 0.7, 1.0); to: Qt.vector3d(-1.7, 0.0, 0.9); color: "#505000" }
+        VRBox { from: Qt.vector3d( 0.0, 0.0, 1.0); to: Qt.vector3d(-0.1, 0.7, 0.9); color: "#505000" }
+        VRBox { from: Qt.vector3d( 0.0, 0.7, 0.0); to: Qt.vector3d(-0.1, 0.0, 0.1); color: "#505000" }
+
+        VRBox { from: Qt.vector3d(-1.4, 0.5,  -1.1);  to: Qt.vector3d(-0.8,  0.55, -0.5);  color: "#202050" } // Chair seat
+        VRBox { from: Qt.vector3d(-1.4, 0.0,  -1.1);  to: Qt.vector3d(-1.34, 1.0,  -1.04); color: "#202050" } // Chair legs
+        VRBox { from: Qt.vector3d(-1.4, 0.5,  -0.5);  to: Qt.vector3d(-1.34, 0.0,  -0.56); color: "#202050" }
+        VRBox { from: Qt.vector3d(-0.8, 0.0,  -0.5);  to: Qt.vector3d(-0.86, 0.5,  -0.56); color: "#202050" }
+        VRBox { from: Qt.vector3d(-0.8, 1.0,  -1.1);  to: Qt.vector3d(-0.86, 0.0,  -1.04); color: "#202050" }
+        VRBox { from: Qt.vector3d(-1.4, 0.97, -1.05); to: Qt.vector3d(-0.8,  0.92, -1.10); color: "#202050" } // Chair back high bar
+    }
+
+    // Posts
+    VRModel {
+        material: blankMaterial
+        instanced: true
+
+        Repeater {
+            model: 10
+            VRBox { from: Qt.vector3d(-3, 0.0, 3.0 + 0.4 * index); to: Qt.vector3d(-2.9, 1.3, 3.1 + 0.4 * index); color: "#404040" }
+        }
+    }
+}
@@ -8,6 +8,43 @@ VRWindow {
     title: qsTr("RoomTiny")
     color: "black"
 
+    Room {
+    }
+
+    VRStats {
+        id: stats
+    }
+
+    // Also shown in the headset, below the line of sight. It is only
+    // re-rendered when the text changes, twice a second.
+    VRPanel {
+        x: 8
+        y: 8
+        width: statsText.implicitWidth + 16
+        height: statsText.implicitHeight + 16
+        headLocked: true
+        position: Qt.vector3d(0, -0.3, -1)
+        eulerRotation: Qt.vector3d(-15, 0, 0)
+        quadWidth: 0.5
+
+        Rectangle {
+            anchors.fill: parent
+            color: "#a0000000"
+            radius: 4
+        }
+
+        Text {
+            id: statsText
+            x: 8
+            y: 8
+            color: stats.overBudgetRatio > 0.01 ? "red" : "white"
+            font.family: "monospace"
+            text: "cpu p50 %1 p95 %2 p99 %3 ms\ngpu p50 %4 p95 %5 p99 %6 ms"
+                    .arg(stats.cpuP50.toFixed(2)).arg(stats.cpuP95.toFixed(2)).arg(stats.cpuP99.toFixed(2))
+                    .arg(stats.gpuP50.toFixed(2)).arg(stats.gpuP95.toFixed(2)).arg(stats.gpuP99.toFixed(2))
+        }
+    }
+
     VRHeadset {
         id: headset
         x:  0
@@ -28,32 +65,32 @@ VRWindow {
             if (!event.isAutoRepeat) {
                 if (event.key === Qt.Key_Left)
                 {
-                    angularVelocity.y += pressed ? 0.75 : -0.75;
+                    angularVelocity.y += pressed ? 67.5 : -67.5;
                     event.accepted = true;
                 }
                 else if (event.key === Qt.Key_Right)
                 {
-                    angularVelocity.y += pressed ? -0.75 : 0.75;
+                    angularVelocity.y += pressed ? -67.5 : 67.5;
                     event.accepted = true;
                 }
                 else if (event.key === Qt.Key_W || event.key === Qt.Key_Up)
                 {
-                    linearVelocity.z += pressed ? -0.05 : 0.05;
+                    linearVelocity.z += pressed ? -4.5 : 4.5;
                     event.accepted = true;
                 }
                 else if (event.key === Qt.Key_S || event.key === Qt.Key_Down)
                 {
-                    linearVelocity.z += pressed ? 0.05 : -0.05;
+                    linearVelocity.z += pressed ? 4.5 : -4.5;
                     event.accepted = true;
                 }
                 else if (event.key === Qt.Key_A)
                 {
-                    linearVelocity.x += pressed ? -0.05 : 0.05;
+                    linearVelocity.x += pressed ? -4.5 : 4.5;
                     event.accepted = true;
                 }
                 else if (event.key === Qt.Key_D)
                 {
-                    linearVelocity.x += pressed ? 0.05 : -0.05;
+                    linearVelocity.x += pressed ? 4.5 : -4.5;
                     event.accepted = true;
                 }
             }
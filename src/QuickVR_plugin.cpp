@@ -1,13 +1,25 @@
 #include "QuickVR_plugin.h"
 
+#include "VRBox.h"
 #include "VRHeadset.h"
+#include "VRMaterial.h"
+#include "VRMirror.h"
+#include "VRModel.h"
+#include "VRPanel.h"
+#include "VRStats.h"
 #include "VRWindow.h"
 
 #include <qqml.h>
 
 void QuickVRPlugin::registerTypes(const char *uri)
 {
+    qmlRegisterType<VRBox>(uri, 1, 0, "VRBox");
     qmlRegisterType<VRHeadset>(uri, 1, 0, "VRHeadset");
+    qmlRegisterType<VRMaterial>(uri, 1, 0, "VRMaterial");
+    qmlRegisterType<VRMirror>(uri, 1, 0, "VRMirror");
+    qmlRegisterType<VRModel>(uri, 1, 0, "VRModel");
+    qmlRegisterType<VRPanel>(uri, 1, 0, "VRPanel");
+    qmlRegisterType<VRStats>(uri, 1, 0, "VRStats");
     qmlRegisterType<VRWindow>(uri, 1, 0, "VRWindow");
 }
 
@@ -0,0 +1,34 @@
+#include "VRBackend.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QtGlobal>
+
+#include "VRSimBackend.h"
+
+#ifdef HAVE_LIBOVR
+#include "VROvrBackend.h"
+#endif
+
+VRBackend *VRBackend::create()
+{
+    const QByteArray requested = qgetenv("QUICKVR_BACKEND").toLower();
+
+#ifdef HAVE_LIBOVR
+    if (requested.isEmpty() || requested == "ovr")
+    {
+        return new VROvrBackend();
+    }
+#else
+    if (requested == "ovr")
+    {
+        qWarning("QuickVR was built without LibOVR, falling back to the simulated HMD.");
+    }
+#endif
+
+    if (!requested.isEmpty() && requested != "ovr" && requested != "sim")
+    {
+        qWarning("Unknown QUICKVR_BACKEND \"%s\", falling back to the simulated HMD.", requested.constData());
+    }
+
+    return new VRSimBackend();
+}
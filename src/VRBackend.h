@@ -0,0 +1,112 @@
+#ifndef VRBACKEND_H
+#define VRBACKEND_H
+
+#include <QtCore/QRect>
+#include <QtCore/QSize>
+#include <QtCore/QVector>
+#include <QtGui/QMatrix4x4>
+#include <QtGui/QQuaternion>
+#include <QtGui/QVector3D>
+#include <QtGui/qopengl.h>
+
+// Head or eye pose, in tracking space (meters, right handed, -Z forward).
+struct VRPose
+{
+    QQuaternion Orientation;
+    QVector3D   Position;
+};
+
+struct VRSessionStatus
+{
+    bool IsVisible = false;
+    bool HasInputFocus = false;
+    bool ShouldQuit = false;
+    bool ShouldRecenter = false;
+};
+
+// A ring of color (+ depth) textures owned by the backend. The renderer draws
+// into the current textures and commits them once the eye is done. Without
+// depth, currentDepthTexture() returns 0.
+class VRSwapChain
+{
+public:
+    virtual ~VRSwapChain() {}
+
+    virtual QSize size() const = 0;
+    virtual bool isValid() const = 0;
+    virtual GLuint currentColorTexture() = 0;
+    virtual GLuint currentDepthTexture() = 0;
+    virtual void commit() = 0;
+};
+
+// Everything the backend needs to hand one stereo frame over to its compositor.
+struct VREyeLayer
+{
+    VRSwapChain * SwapChain[2] = { nullptr, nullptr };
+    QRect         Viewport[2];
+    VRPose        RenderPose[2];
+    float         ZNear = 0.0f;
+    float         ZFar = 0.0f;
+    double        SensorSampleTime = 0.0;
+};
+
+// A flat textured rectangle the compositor draws over the eye layer,
+// resampling the texture once at display resolution instead of the
+// application drawing it into both eye buffers. The swap chain's committed
+// texture is shown until the next commit, so an unchanged quad costs
+// nothing to resubmit. The pose, in tracking space or relative to the head
+// when HeadLocked, is the center of the rectangle, facing +Z. The texture's
+// bottom row is first, alpha premultiplied.
+struct VRQuadLayer
+{
+    VRSwapChain * SwapChain = nullptr;
+    QRect         Viewport;
+    VRPose        Pose;
+    QSizeF        Size;         // meters
+    bool          HeadLocked = false;
+};
+
+// Abstracts the HMD runtime away from VRRenderer. All methods except
+// initialize() are called on the scene graph render thread with the
+// window's OpenGL context current.
+class VRBackend
+{
+public:
+    virtual ~VRBackend() {}
+
+    // Picks the backend named by the QUICKVR_BACKEND environment variable
+    // ("ovr" or "sim"). Defaults to LibOVR when it was compiled in and to the
+    // simulated HMD otherwise.
+    static VRBackend *create();
+
+    virtual const char *name() const = 0;
+
+    virtual bool initialize() = 0;
+    virtual bool createSession() = 0;
+    virtual void destroySession() = 0;
+
+    virtual double refreshRate() const = 0;
+    virtual QSize recommendedTextureSize(int eye) const = 0;
+    virtual QMatrix4x4 projection(int eye, float zNear, float zFar) const = 0;
+
+    virtual VRSessionStatus sessionStatus() = 0;
+    virtual void recenter() = 0;
+
+    // When the frame will be shown, in seconds on the backend's clock.
+    virtual double predictedDisplayTime(long long frameIndex) const = 0;
+    virtual void getEyePoses(long long frameIndex, VRPose eyePoses[2], double *sensorSampleTime) = 0;
+
+    virtual VRSwapChain *createSwapChain(const QSize &size, bool withDepth) = 0;
+
+    // The quads are drawn over the eye layer, in order.
+    virtual bool submitFrame(long long frameIndex, const VREyeLayer &layer, const QVector<VRQuadLayer> &quads) = 0;
+
+    // Returns a texture holding the compositor output, suitable for blitting
+    // into the desktop window, top row first: both eyes side by side, or the
+    // left eye alone. The texture is owned by the backend, a new one
+    // replaces the previous.
+    virtual GLuint createMirrorTexture(const QSize &size, bool leftEyeOnly) = 0;
+    virtual void destroyMirrorTexture() = 0;
+};
+
+#endif // VRBACKEND_H
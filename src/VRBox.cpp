@@ -0,0 +1,36 @@
+#include "VRBox.h"
+
+VRBox::VRBox(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+}
+
+void VRBox::setFrom(const QVector3D &newFrom)
+{
+    if (m_from != newFrom)
+    {
+        m_from = newFrom;
+        emit fromChanged(newFrom);
+        emit boxChanged();
+    }
+}
+
+void VRBox::setTo(const QVector3D &newTo)
+{
+    if (m_to != newTo)
+    {
+        m_to = newTo;
+        emit toChanged(newTo);
+        emit boxChanged();
+    }
+}
+
+void VRBox::setColor(const QColor &newColor)
+{
+    if (m_color != newColor)
+    {
+        m_color = newColor;
+        emit colorChanged(newColor);
+        emit boxChanged();
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef VRBOX_H
+#define VRBOX_H
+
+#include <QColor>
+#include <QQuickItem>
+#include <QVector3D>
+
+// Axis aligned box between two corners, in the space of the VRModel it is a
+// child of. Boxes can be created by a Repeater.
+class VRBox : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(QVector3D from READ from WRITE setFrom NOTIFY fromChanged)
+    Q_PROPERTY(QVector3D to READ to WRITE setTo NOTIFY toChanged)
+    Q_PROPERTY(QColor color READ color WRITE setColor NOTIFY colorChanged)
+
+public:
+    explicit VRBox(QQuickItem *parent = nullptr);
+
+    const QVector3D &from() const { return m_from; }
+    const QVector3D &to() const { return m_to; }
+    const QColor &color() const { return m_color; }
+
+    void setFrom(const QVector3D &newFrom);
+    void setTo(const QVector3D &newTo);
+    void setColor(const QColor &newColor);
+
+signals:
+    void fromChanged(const QVector3D &);
+    void toChanged(const QVector3D &);
+    void colorChanged(const QColor &);
+
+    // Any of the above.
+    void boxChanged();
+
+private:
+    QVector3D m_from;
+    QVector3D m_to = QVector3D(1, 1, 1);
+    QColor m_color = Qt::white;
+};
+
+#endif // VRBOX_H
@@ -0,0 +1,203 @@
+#include "VRCulling.h"
+#include "VRSimd.h"
+
+#include <algorithm>
+
+void VRBounds::expand(const QVector3D &point)
+{
+    Min = QVector3D(qMin(Min.x(), point.x()), qMin(Min.y(), point.y()), qMin(Min.z(), point.z()));
+    Max = QVector3D(qMax(Max.x(), point.x()), qMax(Max.y(), point.y()), qMax(Max.z(), point.z()));
+}
+
+void VRBounds::expand(const VRBounds &other)
+{
+    if (!other.isEmpty())
+    {
+        expand(other.Min);
+        expand(other.Max);
+    }
+}
+
+// Center and half extent: the center moves with the transform, and each
+// axis of the new extent sums the absolute contributions of the old axes.
+// Same result as transforming all eight corners, for affine transforms.
+VRBounds VRBounds::transformed(const QMatrix4x4 &transform) const
+{
+    VRBounds result;
+    if (isEmpty())
+        return result;
+
+    using namespace VRSimd;
+    const float *m = transform.constData();
+    const Float4 c0 = load(m), c1 = load(m + 4), c2 = load(m + 8), c3 = load(m + 12);
+
+    const QVector3D center = this->center();
+    const QVector3D extent = (Max - Min) * 0.5f;
+
+    const Float4 newCenter = add(add(mul(c0, splat(center.x())), mul(c1, splat(center.y()))),
+                                 add(mul(c2, splat(center.z())), c3));
+    const Float4 newExtent = add(add(mul(abs(c0), splat(extent.x())), mul(abs(c1), splat(extent.y()))),
+                                 mul(abs(c2), splat(extent.z())));
+
+    float lo[4], hi[4];
+    store(lo, sub(newCenter, newExtent));
+    store(hi, add(newCenter, newExtent));
+    result.Min = QVector3D(lo[0], lo[1], lo[2]);
+    result.Max = QVector3D(hi[0], hi[1], hi[2]);
+    return result;
+}
+
+VRFrustum::VRFrustum()
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        m_x[i] = m_y[i] = m_z[i] = 0.0f;
+        m_w[i] = 1.0f;
+    }
+}
+
+VRFrustum::VRFrustum(const QMatrix4x4 &viewProj)
+    : VRFrustum()
+{
+    // Rows of the column major matrix, read across its columns.
+    using namespace VRSimd;
+    const float *m = viewProj.constData();
+    const Float4 x = set(m[0], m[4], m[8], m[12]);
+    const Float4 y = set(m[1], m[5], m[9], m[13]);
+    const Float4 z = set(m[2], m[6], m[10], m[14]);
+    const Float4 w = set(m[3], m[7], m[11], m[15]);
+
+    // -w <= x, y, z <= w
+    const Float4 planes[6] = { add(w, x), sub(w, x), add(w, y), sub(w, y), add(w, z), sub(w, z) };
+    for (int i = 0; i < 6; ++i)
+    {
+        float plane[4];
+        store(plane, planes[i]);
+        m_x[i] = plane[0];
+        m_y[i] = plane[1];
+        m_z[i] = plane[2];
+        m_w[i] = plane[3];
+    }
+}
+
+bool VRFrustum::intersects(const VRBounds &bounds) const
+{
+    using namespace VRSimd;
+    const Float4 minX = splat(bounds.Min.x()), minY = splat(bounds.Min.y()), minZ = splat(bounds.Min.z());
+    const Float4 maxX = splat(bounds.Max.x()), maxY = splat(bounds.Max.y()), maxZ = splat(bounds.Max.z());
+
+    for (int i = 0; i < 8; i += 4)
+    {
+        // Distance of the corner furthest along each plane normal
+        const Float4 px = load(m_x + i), py = load(m_y + i), pz = load(m_z + i);
+        const Float4 d = add(add(maximum(mul(px, minX), mul(px, maxX)), maximum(mul(py, minY), mul(py, maxY))),
+                             add(maximum(mul(pz, minZ), mul(pz, maxZ)), load(m_w + i)));
+        if (anyNegative(d))
+            return false;
+    }
+    return true;
+}
+
+void VRBvh::build(const QVector<VRBounds> &items)
+{
+    clear();
+    if (items.isEmpty())
+        return;
+
+    m_bounds = items;
+    m_items.resize(items.size());
+    for (int i = 0; i < items.size(); ++i)
+    {
+        m_items[i] = i;
+    }
+
+    m_nodes.reserve(2 * (items.size() / kLeafSize + 1));
+    m_nodes.append(Node());
+    subdivide(0, 0, items.size());
+}
+
+void VRBvh::clear()
+{
+    m_nodes.clear();
+    m_items.clear();
+    m_bounds.clear();
+}
+
+void VRBvh::subdivide(int node, int first, int count)
+{
+    VRBounds bounds;
+    VRBounds centers;
+    for (int i = first; i < first + count; ++i)
+    {
+        bounds.expand(m_bounds[m_items[i]]);
+        centers.expand(m_bounds[m_items[i]].center());
+    }
+    m_nodes[node].Bounds = bounds;
+
+    if (count <= kLeafSize)
+    {
+        m_nodes[node].First = first;
+        m_nodes[node].Count = count;
+        return;
+    }
+
+    const QVector3D extent = centers.Max - centers.Min;
+    const int axis = extent.x() > extent.y() ? (extent.x() > extent.z() ? 0 : 2) : (extent.y() > extent.z() ? 1 : 2);
+
+    const int middle = first + count / 2;
+    std::nth_element(m_items.begin() + first, m_items.begin() + middle, m_items.begin() + first + count,
+                     [this, axis](int a, int b) { return m_bounds[a].center()[axis] < m_bounds[b].center()[axis]; });
+
+    const int left = m_nodes.size();
+    m_nodes.append(Node());
+    m_nodes.append(Node());
+    m_nodes[node].First = left;
+    m_nodes[node].Count = 0;
+
+    subdivide(left, first, middle - first);
+    subdivide(left + 1, middle, first + count - middle);
+}
+
+void VRBvh::query(const VRFrustum *frusta, int frustumCount, QVector<int> &visible) const
+{
+    if (m_nodes.isEmpty())
+        return;
+
+    int stack[64];
+    int top = 0;
+    stack[top++] = 0;
+
+    while (top > 0)
+    {
+        const Node &node = m_nodes[stack[--top]];
+
+        bool inside = false;
+        for (int f = 0; f < frustumCount && !inside; ++f)
+        {
+            inside = frusta[f].intersects(node.Bounds);
+        }
+        if (!inside)
+            continue;
+
+        if (node.Count > 0)
+        {
+            for (int i = node.First; i < node.First + node.Count; ++i)
+            {
+                const int item = m_items[i];
+                for (int f = 0; f < frustumCount; ++f)
+                {
+                    if (frusta[f].intersects(m_bounds[item]))
+                    {
+                        visible.append(item);
+                        break;
+                    }
+                }
+            }
+        }
+        else
+        {
+            stack[top++] = node.First;
+            stack[top++] = node.First + 1;
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef VRCULLING_H
+#define VRCULLING_H
+
+#include <QtCore/QVector>
+#include <QtGui/QMatrix4x4>
+#include <QtGui/QVector3D>
+#include <QtGui/QVector4D>
+
+// Axis aligned bounding box. Default constructed boxes are empty.
+struct VRBounds
+{
+    QVector3D Min = QVector3D(1e30f, 1e30f, 1e30f);
+    QVector3D Max = QVector3D(-1e30f, -1e30f, -1e30f);
+
+    bool isEmpty() const { return Min.x() > Max.x(); }
+    QVector3D center() const { return (Min + Max) * 0.5f; }
+
+    void expand(const QVector3D &point);
+    void expand(const VRBounds &other);
+
+    // Bounds of this box after an affine transform, still axis aligned.
+    VRBounds transformed(const QMatrix4x4 &transform) const;
+};
+
+// The six clip planes of a view-projection matrix, pointing inwards. Kept
+// one component per array, so a box is tested against four planes at once;
+// the last two slots hold a plane nothing is outside of.
+class VRFrustum
+{
+public:
+    VRFrustum();
+    explicit VRFrustum(const QMatrix4x4 &viewProj);
+
+    // Conservative: boxes straddling a corner of the frustum pass.
+    bool intersects(const VRBounds &bounds) const;
+
+private:
+    float m_x[8];
+    float m_y[8];
+    float m_z[8];
+    float m_w[8];
+};
+
+// Bounding volume hierarchy over a fixed set of boxes, built top down with
+// median splits along the longest axis. Nodes are stored flat, children of
+// an inner node are adjacent.
+class VRBvh
+{
+public:
+    void build(const QVector<VRBounds> &items);
+    void clear();
+
+    bool isEmpty() const { return m_nodes.isEmpty(); }
+
+    // Appends the indices of the items visible in any of the frusta. Used
+    // with both eye frusta, so each node is visited once for the union.
+    void query(const VRFrustum *frusta, int frustumCount, QVector<int> &visible) const;
+
+private:
+    static const int kLeafSize = 4;
+
+    struct Node
+    {
+        VRBounds Bounds;
+        int      First;     // first item for leaves, left child otherwise
+        int      Count;     // 0 for inner nodes
+    };
+
+    void subdivide(int node, int first, int count);
+
+    QVector<Node> m_nodes;
+    QVector<int> m_items;
+    QVector<VRBounds> m_bounds;
+};
+
+#endif // VRCULLING_H
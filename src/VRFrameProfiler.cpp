@@ -0,0 +1,241 @@
+#include "VRFrameProfiler.h"
+
+#include <QtGui/QOpenGLContext>
+
+VRFrameProfiler::VRFrameProfiler(VRFrameStatistics *statistics)
+    : m_statistics(statistics)
+{
+    memset(m_querySets, 0, sizeof(m_querySets));
+}
+
+VRFrameProfiler::~VRFrameProfiler()
+{
+}
+
+void VRFrameProfiler::initialize()
+{
+    initializeOpenGLFunctions();
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+
+    // Timer queries are core in desktop OpenGL 3.3, but the 64 bit result
+    // getter is not part of QOpenGLExtraFunctions.
+    if (!context->isOpenGLES())
+    {
+        m_glGetQueryObjectui64v = (GetQueryObjectui64v) context->getProcAddress("glGetQueryObjectui64v");
+    }
+    m_gpuTimers = m_glGetQueryObjectui64v != nullptr;
+
+    if (m_gpuTimers)
+    {
+        for (int i = 0; i < kQueryLatency; ++i)
+        {
+            glGenQueries(VRFrameStatistics::PhaseCount, m_querySets[i].Queries);
+            glGenQueries(VRFrameStatistics::PhaseCount, m_querySets[i].SampleQueries);
+            m_querySets[i].Pending = false;
+        }
+    }
+    else
+    {
+        qWarning("GL_TIME_ELAPSED queries not available, GPU frame timings are disabled.");
+    }
+}
+
+void VRFrameProfiler::release()
+{
+    if (m_gpuTimers)
+    {
+        for (int i = 0; i < kQueryLatency; ++i)
+        {
+            glDeleteQueries(VRFrameStatistics::PhaseCount, m_querySets[i].Queries);
+            glDeleteQueries(VRFrameStatistics::PhaseCount, m_querySets[i].SampleQueries);
+        }
+        memset(m_querySets, 0, sizeof(m_querySets));
+        m_gpuTimers = false;
+    }
+}
+
+bool VRFrameProfiler::isGpuPhase(Phase phase)
+{
+    return phase == VRFrameStatistics::RenderLeftEye ||
+           phase == VRFrameStatistics::RenderRightEye ||
+           phase == VRFrameStatistics::RenderStereo ||
+           phase == VRFrameStatistics::Panels ||
+           phase == VRFrameStatistics::SubmitFrame ||
+           phase == VRFrameStatistics::MirrorBlit;
+}
+
+void VRFrameProfiler::beginFrame(long long frameIndex)
+{
+    if (m_gpuTimers)
+    {
+        collectGpuResults();
+
+        // Still waiting on this set after kQueryLatency frames: the GPU is
+        // far behind, give up on that frame rather than block.
+        QuerySet &set = m_querySets[m_currentQuerySet];
+        set.Pending = false;
+        memset(set.Issued, 0, sizeof(set.Issued));
+        memset(set.SamplesIssued, 0, sizeof(set.SamplesIssued));
+        set.FrameIndex = frameIndex;
+    }
+
+    m_frameIndex = frameIndex;
+    for (int phase = 0; phase < VRFrameStatistics::PhaseCount; ++phase)
+    {
+        m_cpuNs[phase] = -1;
+    }
+    m_counters = VRFrameStatistics::DrawCounters();
+
+    m_inFrame = true;
+    m_frameTimer.start();
+}
+
+void VRFrameProfiler::endFrame()
+{
+    if (!m_inFrame)
+        return;
+
+    m_cpuNs[VRFrameStatistics::Frame] = m_frameTimer.nsecsElapsed();
+    m_statistics->addCpuSample(m_frameIndex, m_cpuNs, m_counters);
+
+    if (m_gpuTimers)
+    {
+        m_querySets[m_currentQuerySet].Pending = true;
+        m_currentQuerySet = (m_currentQuerySet + 1) % kQueryLatency;
+    }
+
+    m_inFrame = false;
+}
+
+void VRFrameProfiler::abortFrame()
+{
+    m_inFrame = false;
+}
+
+void VRFrameProfiler::begin(Phase phase)
+{
+    m_phaseStart[phase] = m_frameTimer.nsecsElapsed();
+
+    if (m_gpuTimers && isGpuPhase(phase))
+    {
+        QuerySet &set = m_querySets[m_currentQuerySet];
+        if (!set.Issued[phase])
+        {
+            glBeginQuery(GL_TIME_ELAPSED, set.Queries[phase]);
+        }
+    }
+}
+
+void VRFrameProfiler::end(Phase phase)
+{
+    const qint64 elapsed = m_frameTimer.nsecsElapsed() - m_phaseStart[phase];
+    m_cpuNs[phase] = (m_cpuNs[phase] < 0 ? 0 : m_cpuNs[phase]) + elapsed;
+
+    if (m_gpuTimers && isGpuPhase(phase))
+    {
+        QuerySet &set = m_querySets[m_currentQuerySet];
+        if (!set.Issued[phase])
+        {
+            glEndQuery(GL_TIME_ELAPSED);
+            set.Issued[phase] = true;
+        }
+    }
+}
+
+void VRFrameProfiler::beginSamples(Phase phase)
+{
+    if (m_gpuTimers && isGpuPhase(phase))
+    {
+        QuerySet &set = m_querySets[m_currentQuerySet];
+        if (!set.SamplesIssued[phase])
+        {
+            glBeginQuery(GL_SAMPLES_PASSED, set.SampleQueries[phase]);
+        }
+    }
+}
+
+void VRFrameProfiler::endSamples(Phase phase)
+{
+    if (m_gpuTimers && isGpuPhase(phase))
+    {
+        QuerySet &set = m_querySets[m_currentQuerySet];
+        if (!set.SamplesIssued[phase])
+        {
+            glEndQuery(GL_SAMPLES_PASSED);
+            set.SamplesIssued[phase] = true;
+        }
+    }
+}
+
+qint64 VRFrameProfiler::takeGpuFrameTime()
+{
+    const qint64 ns = m_latestGpuFrameNs;
+    m_latestGpuFrameNs = -1;
+    return ns;
+}
+
+void VRFrameProfiler::collectGpuResults()
+{
+    for (int i = 0; i < kQueryLatency; ++i)
+    {
+        QuerySet &set = m_querySets[i];
+        if (!set.Pending)
+            continue;
+
+        // Queries complete in order, checking the last one issued is enough.
+        GLuint lastQuery = 0;
+        for (int phase = VRFrameStatistics::PhaseCount - 1; phase >= 0; --phase)
+        {
+            if (set.Issued[phase])
+            {
+                lastQuery = set.Queries[phase];
+                break;
+            }
+        }
+
+        if (lastQuery)
+        {
+            GLuint available = 0;
+            glGetQueryObjectuiv(lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                continue;
+        }
+
+        qint64 gpuNs[VRFrameStatistics::PhaseCount];
+        qint64 total = 0;
+        for (int phase = 0; phase < VRFrameStatistics::PhaseCount; ++phase)
+        {
+            gpuNs[phase] = -1;
+            if (set.Issued[phase])
+            {
+                GLuint64 result = 0;
+                m_glGetQueryObjectui64v(set.Queries[phase], GL_QUERY_RESULT, &result);
+                gpuNs[phase] = qint64(result);
+                total += gpuNs[phase];
+            }
+        }
+        gpuNs[VRFrameStatistics::Frame] = total;
+
+        // Sample queries end before their phase's timer query, they are
+        // available too.
+        qint64 samples = -1;
+        for (int phase = 0; phase < VRFrameStatistics::PhaseCount; ++phase)
+        {
+            if (set.SamplesIssued[phase])
+            {
+                GLuint64 result = 0;
+                m_glGetQueryObjectui64v(set.SampleQueries[phase], GL_QUERY_RESULT, &result);
+                samples = qMax<qint64>(samples, 0) + qint64(result);
+            }
+        }
+
+        m_statistics->addGpuSample(set.FrameIndex, gpuNs, samples);
+        if (set.FrameIndex > m_latestGpuFrameIndex)
+        {
+            m_latestGpuFrameIndex = set.FrameIndex;
+            m_latestGpuFrameNs = total;
+        }
+        set.Pending = false;
+    }
+}
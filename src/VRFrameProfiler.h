@@ -0,0 +1,82 @@
+#ifndef VRFRAMEPROFILER_H
+#define VRFRAMEPROFILER_H
+
+#include <QtCore/QElapsedTimer>
+#include <QtGui/QOpenGLExtraFunctions>
+
+#include "VRFrameStatistics.h"
+
+// Render thread side of the frame statistics. CPU phases are timed with
+// QElapsedTimer and may be entered several times per frame, their times add
+// up. GPU phases use GL_TIME_ELAPSED queries, which cannot nest, so only the
+// phases that actually issue GPU work are measured there. Query results are
+// read back a few frames later to never stall the pipeline.
+class VRFrameProfiler : protected QOpenGLExtraFunctions
+{
+public:
+    typedef VRFrameStatistics::Phase Phase;
+
+    explicit VRFrameProfiler(VRFrameStatistics *statistics);
+    ~VRFrameProfiler();
+
+    // Must be called with the OpenGL context current.
+    void initialize();
+    void release();
+
+    bool hasGpuTimers() const { return m_gpuTimers; }
+
+    void beginFrame(long long frameIndex);
+    void endFrame();
+    void abortFrame();
+
+    void begin(Phase phase);
+    void end(Phase phase);
+
+    // Counts the samples that pass the depth test between the two calls,
+    // at most once per GPU phase and frame; the totals are reported with the
+    // GPU times. Nests inside begin() and end().
+    void beginSamples(Phase phase);
+    void endSamples(Phase phase);
+
+    // GPU time of the most recent frame whose queries completed since the
+    // last call, in nanoseconds, or -1.
+    qint64 takeGpuFrameTime();
+
+    // Driver call counters of the current frame, reset by beginFrame().
+    VRFrameStatistics::DrawCounters &counters() { return m_counters; }
+
+private:
+    static const int kQueryLatency = 4;
+
+    static bool isGpuPhase(Phase phase);
+    void collectGpuResults();
+
+    typedef void (APIENTRYP GetQueryObjectui64v)(GLuint id, GLenum pname, GLuint64 *params);
+
+    VRFrameStatistics *m_statistics;
+    GetQueryObjectui64v m_glGetQueryObjectui64v = nullptr;
+    bool m_gpuTimers = false;
+    bool m_inFrame = false;
+
+    long long m_frameIndex = 0;
+    QElapsedTimer m_frameTimer;
+    qint64 m_phaseStart[VRFrameStatistics::PhaseCount];
+    qint64 m_cpuNs[VRFrameStatistics::PhaseCount];
+    VRFrameStatistics::DrawCounters m_counters;
+
+    struct QuerySet
+    {
+        GLuint    Queries[VRFrameStatistics::PhaseCount];
+        bool      Issued[VRFrameStatistics::PhaseCount];
+        GLuint    SampleQueries[VRFrameStatistics::PhaseCount];
+        bool      SamplesIssued[VRFrameStatistics::PhaseCount];
+        long long FrameIndex;
+        bool      Pending;
+    };
+    QuerySet m_querySets[kQueryLatency];
+    int m_currentQuerySet = 0;
+    qint64 m_latestGpuFrameNs = -1;
+    long long m_latestGpuFrameIndex = -1;
+};
+
+#endif // VRFRAMEPROFILER_H
@@ -0,0 +1,186 @@
+#include "VRFrameStatistics.h"
+
+#include <QtCore/QMutexLocker>
+
+#include <algorithm>
+
+static const int kDefaultWindowSize = 300;
+
+static VRFrameStatistics::Percentiles ComputePercentiles(QVector<qint64> &values)
+{
+    VRFrameStatistics::Percentiles result;
+    if (values.isEmpty())
+    {
+        return result;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    // Nearest-rank percentiles.
+    auto rank = [&values](double p) {
+        int index = int(p * values.size() + 0.5) - 1;
+        return values[qBound(0, index, values.size() - 1)] / 1e6;
+    };
+
+    result.P50 = rank(0.50);
+    result.P95 = rank(0.95);
+    result.P99 = rank(0.99);
+    return result;
+}
+
+VRFrameStatistics::VRFrameStatistics()
+    : m_samples(kDefaultWindowSize)
+{
+}
+
+const char *VRFrameStatistics::phaseName(Phase phase)
+{
+    switch (phase)
+    {
+    case SessionStatus:  return "sessionStatus";
+    case EyePoses:       return "eyePoses";
+    case RenderLeftEye:  return "renderLeftEye";
+    case RenderRightEye: return "renderRightEye";
+    case RenderStereo:   return "renderStereo";
+    case Commit:         return "commit";
+    case Panels:         return "panels";
+    case SubmitFrame:    return "submitFrame";
+    case MirrorBlit:     return "mirrorBlit";
+    case Frame:          return "frame";
+    case PhaseCount:     break;
+    }
+    return "";
+}
+
+int VRFrameStatistics::windowSize() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_samples.size();
+}
+
+void VRFrameStatistics::setWindowSize(int frames)
+{
+    QMutexLocker lock(&m_mutex);
+    if (frames > 0 && frames != m_samples.size())
+    {
+        m_samples = QVector<Sample>(frames);
+    }
+}
+
+void VRFrameStatistics::setRefreshRate(double hz)
+{
+    QMutexLocker lock(&m_mutex);
+    m_refreshRate = hz;
+}
+
+void VRFrameStatistics::addCpuSample(long long frameIndex, const qint64 cpuNs[PhaseCount], const DrawCounters &calls)
+{
+    QMutexLocker lock(&m_mutex);
+
+    Sample &sample = m_samples[int(frameIndex % m_samples.size())];
+    sample.FrameIndex = frameIndex;
+    sample.HasGpu = false;
+    sample.ShadedSamples = -1;
+    sample.Calls = calls;
+    for (int phase = 0; phase < PhaseCount; ++phase)
+    {
+        sample.CpuNs[phase] = cpuNs[phase];
+        sample.GpuNs[phase] = -1;
+    }
+}
+
+void VRFrameStatistics::addGpuSample(long long frameIndex, const qint64 gpuNs[PhaseCount], qint64 shadedSamples)
+{
+    QMutexLocker lock(&m_mutex);
+
+    // GPU results trail the CPU by a few frames; drop them if the CPU sample
+    // has already been recycled.
+    Sample &sample = m_samples[int(frameIndex % m_samples.size())];
+    if (sample.FrameIndex != frameIndex)
+    {
+        return;
+    }
+
+    sample.HasGpu = true;
+    sample.ShadedSamples = shadedSamples;
+    for (int phase = 0; phase < PhaseCount; ++phase)
+    {
+        sample.GpuNs[phase] = gpuNs[phase];
+    }
+}
+
+VRFrameStatistics::Summary VRFrameStatistics::summarize() const
+{
+    QVector<Sample> samples;
+    double refreshRate;
+    {
+        QMutexLocker lock(&m_mutex);
+        samples = m_samples;
+        refreshRate = m_refreshRate;
+    }
+
+    Summary summary;
+    summary.FrameBudget = refreshRate > 0.0 ? 1000.0 / refreshRate : 0.0;
+
+    const qint64 budgetNs = refreshRate > 0.0 ? qint64(1e9 / refreshRate) : 0;
+    int overBudget = 0;
+    long long latestFrame = -1;
+    qint64 shadedSamples = 0;
+    int shadedFrames = 0;
+
+    QVector<qint64> values;
+    values.reserve(samples.size());
+
+    for (int phase = 0; phase < PhaseCount; ++phase)
+    {
+        values.clear();
+        for (const Sample &sample : samples)
+        {
+            if (sample.FrameIndex >= 0 && sample.CpuNs[phase] >= 0)
+                values.append(sample.CpuNs[phase]);
+        }
+        summary.Cpu[phase] = ComputePercentiles(values);
+
+        values.clear();
+        for (const Sample &sample : samples)
+        {
+            if (sample.FrameIndex >= 0 && sample.HasGpu && sample.GpuNs[phase] >= 0)
+                values.append(sample.GpuNs[phase]);
+        }
+        summary.Gpu[phase] = ComputePercentiles(values);
+    }
+
+    for (const Sample &sample : samples)
+    {
+        if (sample.FrameIndex < 0)
+            continue;
+
+        ++summary.SampleCount;
+        if (sample.FrameIndex > latestFrame)
+        {
+            latestFrame = sample.FrameIndex;
+            summary.Calls = sample.Calls;
+        }
+        if (sample.HasGpu)
+            ++summary.GpuSampleCount;
+        if (sample.HasGpu && sample.ShadedSamples >= 0)
+        {
+            shadedSamples += sample.ShadedSamples;
+            ++shadedFrames;
+        }
+
+        if (budgetNs > 0 && (sample.CpuNs[Frame] > budgetNs || (sample.HasGpu && sample.GpuNs[Frame] > budgetNs)))
+            ++overBudget;
+    }
+
+    if (summary.SampleCount > 0)
+    {
+        summary.OverBudgetRatio = double(overBudget) / summary.SampleCount;
+    }
+    if (shadedFrames > 0)
+    {
+        summary.ShadedSamples = double(shadedSamples) / shadedFrames;
+    }
+
+    return summary;
+}
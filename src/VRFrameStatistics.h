@@ -0,0 +1,90 @@
+#ifndef VRFRAMESTATISTICS_H
+#define VRFRAMESTATISTICS_H
+
+#include <QtCore/QMutex>
+#include <QtCore/QVector>
+
+// Rolling window of per-frame timings. Written by the render thread through
+// VRFrameProfiler, read by VRStats on the GUI thread.
+class VRFrameStatistics
+{
+public:
+    enum Phase
+    {
+        SessionStatus,
+        EyePoses,
+        RenderLeftEye,
+        RenderRightEye,
+        RenderStereo,
+        Commit,
+        Panels,
+        SubmitFrame,
+        MirrorBlit,
+        Frame,
+        PhaseCount
+    };
+
+    struct Percentiles
+    {
+        double P50 = 0.0;
+        double P95 = 0.0;
+        double P99 = 0.0;
+    };
+
+    // OpenGL calls issued while drawing the scene during one frame, counted
+    // as Scene::Render issues them. It makes no glGet* queries.
+    struct DrawCounters
+    {
+        int DrawCalls = 0;      // glDraw*
+        int StateChanges = 0;   // enables, program, texture, buffer and vertex array binds
+        int UniformUploads = 0; // glUniform*
+        int Culled = 0;         // models and batches skipped by frustum culling, not a GL call
+
+        int total() const { return DrawCalls + StateChanges + UniformUploads; }
+    };
+
+    // All times in milliseconds.
+    struct Summary
+    {
+        int          SampleCount = 0;
+        int          GpuSampleCount = 0;
+        double       FrameBudget = 0.0;
+        double       OverBudgetRatio = 0.0;
+        Percentiles  Cpu[PhaseCount];
+        Percentiles  Gpu[PhaseCount];
+        DrawCounters Calls;     // most recent frame
+        double       ShadedSamples = 0.0;   // mean per frame, samples passing the depth test in the eye buffers
+    };
+
+    VRFrameStatistics();
+
+    static const char *phaseName(Phase phase);
+
+    int windowSize() const;
+    void setWindowSize(int frames);
+
+    void setRefreshRate(double hz);
+
+    // Times are in nanoseconds, -1 when the phase was not measured.
+    void addCpuSample(long long frameIndex, const qint64 cpuNs[PhaseCount], const DrawCounters &calls);
+    void addGpuSample(long long frameIndex, const qint64 gpuNs[PhaseCount], qint64 shadedSamples);
+
+    Summary summarize() const;
+
+private:
+    struct Sample
+    {
+        long long    FrameIndex = -1;
+        qint64       CpuNs[PhaseCount];
+        qint64       GpuNs[PhaseCount];
+        bool         HasGpu = false;
+        qint64       ShadedSamples = -1;
+        DrawCounters Calls;
+    };
+
+    mutable QMutex m_mutex;
+    QVector<Sample> m_samples;
+    double m_refreshRate = 0.0;
+};
+
+#endif // VRFRAMESTATISTICS_H
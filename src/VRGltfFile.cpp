@@ -0,0 +1,261 @@
+#include "VRGltfFile.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QUrl>
+#include <QtGui/QQuaternion>
+
+#include <cstring>
+
+static quint32 readUint32(const QByteArray &data, int offset)
+{
+    quint32 value = 0;
+    if (offset >= 0 && offset + 4 <= data.size())
+        memcpy(&value, data.constData() + offset, 4);
+    return value;
+}
+
+static int componentCount(const QString &type)
+{
+    if (type == QLatin1String("SCALAR")) return 1;
+    if (type == QLatin1String("VEC2"))   return 2;
+    if (type == QLatin1String("VEC3"))   return 3;
+    if (type == QLatin1String("VEC4"))   return 4;
+    if (type == QLatin1String("MAT4"))   return 16;
+    return 0;
+}
+
+bool VRGltfFile::open(const QString &fileName, QString *error)
+{
+    m_json = QJsonObject();
+    m_buffers.clear();
+    m_directory = QFileInfo(fileName).absolutePath();
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        *error = file.errorString();
+        return false;
+    }
+    const QByteArray data = file.readAll();
+
+    // A .glb is a 12 byte header and chunks: JSON first, then an optional
+    // binary chunk that stands in for the first buffer.
+    QByteArray json = data;
+    QByteArray binary;
+    if (data.startsWith("glTF"))
+    {
+        if (readUint32(data, 4) != 2)
+        {
+            *error = QStringLiteral("only glTF 2.0 is supported");
+            return false;
+        }
+
+        int offset = 12;
+        json.clear();
+        while (offset + 8 <= data.size())
+        {
+            const int length = int(readUint32(data, offset));
+            const quint32 type = readUint32(data, offset + 4);
+            if (length < 0 || offset + 8 + length > data.size())
+                break;
+
+            if (type == 0x4E4F534A)         // "JSON"
+                json = data.mid(offset + 8, length);
+            else if (type == 0x004E4942)    // "BIN\0"
+                binary = data.mid(offset + 8, length);
+            offset += 8 + length;
+        }
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(json, &parseError);
+    if (!document.isObject())
+    {
+        *error = parseError.errorString();
+        return false;
+    }
+    m_json = document.object();
+
+    if (!m_json.value(QLatin1String("asset")).toObject().value(QLatin1String("version")).toString().startsWith(QLatin1Char('2')))
+    {
+        *error = QStringLiteral("only glTF 2.0 is supported");
+        return false;
+    }
+
+    const QJsonArray buffers = array("buffers");
+    for (int i = 0; i < buffers.size(); ++i)
+    {
+        const QString uri = buffers[i].toObject().value(QLatin1String("uri")).toString();
+        QByteArray bytes;
+
+        if (uri.isEmpty())
+        {
+            bytes = binary;
+        }
+        else if (uri.startsWith(QLatin1String("data:")))
+        {
+            const int comma = uri.indexOf(QLatin1Char(','));
+            bytes = QByteArray::fromBase64(uri.mid(comma + 1).toLatin1());
+        }
+        else
+        {
+            QFile bufferFile(m_directory + QLatin1Char('/') + QUrl::fromPercentEncoding(uri.toUtf8()));
+            if (!bufferFile.open(QIODevice::ReadOnly))
+            {
+                *error = QStringLiteral("%1: %2").arg(uri, bufferFile.errorString());
+                return false;
+            }
+            bytes = bufferFile.readAll();
+        }
+
+        if (bytes.size() < buffers[i].toObject().value(QLatin1String("byteLength")).toInt())
+        {
+            *error = QStringLiteral("buffer %1 is truncated").arg(i);
+            return false;
+        }
+        m_buffers.append(bytes);
+    }
+
+    return true;
+}
+
+int VRGltfFile::componentSize(int componentType)
+{
+    switch (componentType)
+    {
+    case Byte:
+    case UnsignedByte:
+        return 1;
+    case Short:
+    case UnsignedShort:
+        return 2;
+    case UnsignedInt:
+    case Float:
+        return 4;
+    }
+    return 0;
+}
+
+bool VRGltfFile::accessor(int index, Accessor *out) const
+{
+    const QJsonObject accessor = array("accessors").at(index).toObject();
+    if (accessor.isEmpty() || accessor.contains(QLatin1String("sparse")))
+        return false;
+
+    out->View = accessor.value(QLatin1String("bufferView")).toInt(-1);
+    const QJsonObject view = array("bufferViews").at(out->View).toObject();
+    const int buffer = view.value(QLatin1String("buffer")).toInt(-1);
+    if (view.isEmpty() || buffer < 0 || buffer >= m_buffers.size())
+        return false;
+
+    out->Count = accessor.value(QLatin1String("count")).toInt();
+    out->Components = componentCount(accessor.value(QLatin1String("type")).toString());
+    out->ComponentType = accessor.value(QLatin1String("componentType")).toInt();
+    out->Normalized = accessor.value(QLatin1String("normalized")).toBool();
+
+    const int elementSize = out->Components * componentSize(out->ComponentType);
+    out->Stride = view.value(QLatin1String("byteStride")).toInt(elementSize);
+
+    out->Offset = accessor.value(QLatin1String("byteOffset")).toInt();
+    const qint64 offset = qint64(view.value(QLatin1String("byteOffset")).toInt()) + out->Offset;
+    const qint64 length = out->Count > 0 ? qint64(out->Count - 1) * out->Stride + elementSize : 0;
+    if (!elementSize || out->Count < 0 || offset < 0 || offset + length > m_buffers[buffer].size())
+        return false;
+
+    out->Data = m_buffers[buffer].constData() + offset;
+    return true;
+}
+
+QVector<float> VRGltfFile::readFloats(int index, int *components) const
+{
+    QVector<float> values;
+    Accessor a;
+    *components = 0;
+    if (!accessor(index, &a))
+        return values;
+
+    *components = a.Components;
+    values.resize(a.Count * a.Components);
+    float *out = values.data();
+
+    for (int i = 0; i < a.Count; ++i)
+    {
+        const char *element = a.Data + qint64(i) * a.Stride;
+        for (int c = 0; c < a.Components; ++c)
+        {
+            float value = 0.0f;
+            switch (a.ComponentType)
+            {
+            case Float:         { float v;   memcpy(&v, element + c * 4, 4); value = v; break; }
+            case UnsignedInt:   { quint32 v; memcpy(&v, element + c * 4, 4); value = float(v); break; }
+            case UnsignedShort: { quint16 v; memcpy(&v, element + c * 2, 2); value = a.Normalized ? v / 65535.0f : v; break; }
+            case Short:         { qint16 v;  memcpy(&v, element + c * 2, 2); value = a.Normalized ? qMax(v / 32767.0f, -1.0f) : v; break; }
+            case UnsignedByte:  { quint8 v = quint8(element[c]); value = a.Normalized ? v / 255.0f : v; break; }
+            case Byte:          { qint8 v = qint8(element[c]);   value = a.Normalized ? qMax(v / 127.0f, -1.0f) : v; break; }
+            }
+            *out++ = value;
+        }
+    }
+    return values;
+}
+
+QVector<quint32> VRGltfFile::readIndices(int index) const
+{
+    QVector<quint32> indices;
+    Accessor a;
+    if (!accessor(index, &a) || a.Components != 1)
+        return indices;
+
+    indices.resize(a.Count);
+    for (int i = 0; i < a.Count; ++i)
+    {
+        const char *element = a.Data + qint64(i) * a.Stride;
+        switch (a.ComponentType)
+        {
+        case UnsignedInt:   { quint32 v; memcpy(&v, element, 4); indices[i] = v; break; }
+        case UnsignedShort: { quint16 v; memcpy(&v, element, 2); indices[i] = v; break; }
+        case UnsignedByte:  indices[i] = quint8(element[0]); break;
+        default:            return QVector<quint32>();
+        }
+    }
+    return indices;
+}
+
+QVector<int> VRGltfFile::sceneRoots() const
+{
+    const QJsonArray scenes = array("scenes");
+    const QJsonObject scene = scenes.at(m_json.value(QLatin1String("scene")).toInt(0)).toObject();
+
+    QVector<int> roots;
+    for (const QJsonValue &node : scene.value(QLatin1String("nodes")).toArray())
+        roots.append(node.toInt());
+    return roots;
+}
+
+QMatrix4x4 VRGltfFile::localTransform(const QJsonObject &node)
+{
+    QMatrix4x4 transform;
+
+    const QJsonArray matrix = node.value(QLatin1String("matrix")).toArray();
+    if (matrix.size() == 16)
+    {
+        // Column major, like QMatrix4x4's raw data.
+        float values[16];
+        for (int i = 0; i < 16; ++i)
+            values[i] = float(matrix[i].toDouble());
+        return QMatrix4x4(values).transposed();
+    }
+
+    const QJsonArray t = node.value(QLatin1String("translation")).toArray();
+    const QJsonArray r = node.value(QLatin1String("rotation")).toArray();
+    const QJsonArray s = node.value(QLatin1String("scale")).toArray();
+    if (t.size() == 3)
+        transform.translate(float(t[0].toDouble()), float(t[1].toDouble()), float(t[2].toDouble()));
+    if (r.size() == 4)
+        transform.rotate(QQuaternion(float(r[3].toDouble()), float(r[0].toDouble()), float(r[1].toDouble()), float(r[2].toDouble())));
+    if (s.size() == 3)
+        transform.scale(float(s[0].toDouble()), float(s[1].toDouble()), float(s[2].toDouble()));
+    return transform;
+}
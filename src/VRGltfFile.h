@@ -0,0 +1,65 @@
+#ifndef VRGLTFFILE_H
+#define VRGLTFFILE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonObject>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtGui/QMatrix4x4>
+
+// Container level access to a glTF 2.0 asset: a .gltf with external or
+// data URI buffers, or a binary .glb. Knows nothing about the renderer,
+// tools/meshconvert uses it as well.
+class VRGltfFile
+{
+public:
+    enum ComponentType
+    {
+        Byte            = 5120,
+        UnsignedByte    = 5121,
+        Short           = 5122,
+        UnsignedShort   = 5123,
+        UnsignedInt     = 5125,
+        Float           = 5126
+    };
+
+    // An accessor resolved to its bytes inside a loaded buffer.
+    struct Accessor
+    {
+        const char * Data = nullptr;
+        int          View = -1;         // buffer view index
+        int          Offset = 0;        // bytes into the view
+        int          Count = 0;
+        int          Components = 0;    // 1 for SCALAR to 4 for VEC4, 16 for MAT4
+        int          ComponentType = 0;
+        int          Stride = 0;        // bytes between elements
+        bool         Normalized = false;
+    };
+
+    bool open(const QString &fileName, QString *error);
+
+    const QJsonObject &json() const { return m_json; }
+    QJsonArray array(const char *name) const { return m_json.value(QLatin1String(name)).toArray(); }
+    QString directory() const { return m_directory; }
+    const QVector<QByteArray> &buffers() const { return m_buffers; }
+
+    bool accessor(int index, Accessor *out) const;
+
+    // Converted to float, normalized integers mapped to [0, 1] or [-1, 1].
+    QVector<float> readFloats(int accessor, int *components) const;
+    QVector<quint32> readIndices(int accessor) const;
+
+    // Root nodes of the default scene, or of the first one.
+    QVector<int> sceneRoots() const;
+
+    static QMatrix4x4 localTransform(const QJsonObject &node);
+    static int componentSize(int componentType);
+
+private:
+    QJsonObject m_json;
+    QVector<QByteArray> m_buffers;
+    QString m_directory;
+};
+
+#endif // VRGLTFFILE_H
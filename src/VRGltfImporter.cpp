@@ -0,0 +1,360 @@
+#include "VRGltfImporter.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QUrl>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Above this many vertices in total, primitives are parsed in parallel.
+const int kParallelVertexCount = 65536;
+
+struct Job
+{
+    QJsonObject                 Json;
+    VRGltfImporter::Primitive   Out;
+    bool                        Valid = false;
+};
+
+// glTF colors are linear, the scene shader expects vertex colors in sRGB
+// and converts them back with the same 2.2 gamma. Alpha stays linear.
+quint32 packColor(const float color[4])
+{
+    const auto byte = [](float v) { return quint32(qBound(0.0f, v, 1.0f) * 255.0f + 0.5f); };
+    const auto encode = [&](float v) { return byte(std::pow(qMax(v, 0.0f), 1.0f / 2.2f)); };
+    return encode(color[0]) | (encode(color[1]) << 8) | (encode(color[2]) << 16) | (byte(color[3]) << 24);
+}
+
+void unpackColor(quint32 packed, float color[4])
+{
+    for (int k = 0; k < 3; ++k)
+        color[k] = std::pow(((packed >> (8 * k)) & 0xff) / 255.0f, 2.2f);
+    color[3] = (packed >> 24) / 255.0f;
+}
+
+void collectNode(const VRGltfFile &gltf, int index, const QMatrix4x4 &parent, QVector<Job> &jobs, int depth)
+{
+    const QJsonObject node = gltf.array("nodes").at(index).toObject();
+    if (node.isEmpty() || depth > 64)
+        return;
+
+    const QMatrix4x4 transform = parent * VRGltfFile::localTransform(node);
+
+    if (node.contains(QLatin1String("mesh")))
+    {
+        const QJsonObject mesh = gltf.array("meshes").at(node.value(QLatin1String("mesh")).toInt()).toObject();
+        for (const QJsonValue &primitive : mesh.value(QLatin1String("primitives")).toArray())
+        {
+            Job job;
+            job.Json = primitive.toObject();
+            job.Out.Transform = transform;
+            job.Out.Material = job.Json.value(QLatin1String("material")).toInt(-1);
+            jobs.append(job);
+        }
+    }
+
+    for (const QJsonValue &child : node.value(QLatin1String("children")).toArray())
+        collectNode(gltf, child.toInt(), transform, jobs, depth + 1);
+}
+
+// Whether glVertexAttribPointer can read the accessor as stored.
+bool isStoredAttribute(const VRGltfFile::Accessor &a, int count, int minComponents, int maxComponents)
+{
+    if (a.Count < count || a.Components < minComponents || a.Components > maxComponents)
+        return false;
+    if (a.ComponentType == VRGltfFile::Float)
+        return true;
+    return a.Normalized && (a.ComponentType == VRGltfFile::UnsignedByte || a.ComponentType == VRGltfFile::UnsignedShort);
+}
+
+// Indices must be tightly packed and in range, glDrawElements doesn't
+// check the latter.
+bool isStoredIndices(const VRGltfFile::Accessor &a, int vertexCount)
+{
+    const int size = VRGltfFile::componentSize(a.ComponentType);
+    if (a.Components != 1 || a.ComponentType == VRGltfFile::Byte || a.ComponentType == VRGltfFile::Short
+        || a.ComponentType == VRGltfFile::Float || a.Stride != size || a.Offset % size || a.Count % 3)
+        return false;
+
+    for (int i = 0; i < a.Count; ++i)
+    {
+        quint32 index = 0;
+        memcpy(&index, a.Data + qint64(i) * size, size_t(size));     // little endian
+        if (index >= quint32(vertexCount))
+            return false;
+    }
+    return true;
+}
+
+void parsePrimitive(const VRGltfFile &gltf, const QVector<VRGltfImporter::Material> &materials, Job &job)
+{
+    if (job.Json.value(QLatin1String("mode")).toInt(4) != 4)
+    {
+        qWarning("Skipping a glTF primitive that isn't a triangle list");
+        return;
+    }
+
+    VRGltfImporter::Primitive &p = job.Out;
+    const QJsonObject attributes = job.Json.value(QLatin1String("attributes")).toObject();
+
+    VRGltfFile::Accessor position;
+    const int positionAccessor = attributes.value(QLatin1String("POSITION")).toInt(-1);
+    if (!gltf.accessor(positionAccessor, &position) || position.Components != 3)
+    {
+        qWarning("Skipping a glTF primitive without positions");
+        return;
+    }
+    p.VertexCount = position.Count;
+
+    // Required for positions, but not always there.
+    const QJsonObject positionJson = gltf.array("accessors").at(positionAccessor).toObject();
+    const QJsonArray min = positionJson.value(QLatin1String("min")).toArray();
+    const QJsonArray max = positionJson.value(QLatin1String("max")).toArray();
+    if (min.size() == 3 && max.size() == 3)
+    {
+        p.Bounds.expand(QVector3D(float(min[0].toDouble()), float(min[1].toDouble()), float(min[2].toDouble())));
+        p.Bounds.expand(QVector3D(float(max[0].toDouble()), float(max[1].toDouble()), float(max[2].toDouble())));
+    }
+
+    const VRGltfImporter::Material material = materials.value(p.Material);
+    const bool hasTexCoord = attributes.contains(QLatin1String("TEXCOORD_0"));
+    const bool hasColor = attributes.contains(QLatin1String("COLOR_0"));
+
+    // Vertex colors are always converted, they have to be encoded to sRGB.
+    VRGltfFile::Accessor texCoord, indices;
+    bool stored = position.ComponentType == VRGltfFile::Float && !hasColor
+            && gltf.accessor(job.Json.value(QLatin1String("indices")).toInt(-1), &indices);
+    if (stored && hasTexCoord)
+        stored = gltf.accessor(attributes.value(QLatin1String("TEXCOORD_0")).toInt(), &texCoord)
+                && isStoredAttribute(texCoord, p.VertexCount, 2, 2);
+    if (stored)
+        stored = isStoredIndices(indices, p.VertexCount);
+
+    if (stored)
+    {
+        p.Position = position;
+        p.TexCoord = texCoord;
+        p.Indices = indices;
+        if (p.Bounds.isEmpty())
+        {
+            for (int i = 0; i < p.VertexCount; ++i)
+            {
+                float v[3];
+                memcpy(v, position.Data + qint64(i) * position.Stride, sizeof(v));
+                p.Bounds.expand(QVector3D(v[0], v[1], v[2]));
+            }
+        }
+        job.Valid = true;
+        return;
+    }
+
+    int components = 0;
+    const QVector<float> positions = gltf.readFloats(positionAccessor, &components);
+    int uvComponents = 0;
+    const QVector<float> uvs = hasTexCoord
+            ? gltf.readFloats(attributes.value(QLatin1String("TEXCOORD_0")).toInt(), &uvComponents) : QVector<float>();
+    int colorComponents = 0;
+    const QVector<float> colors = hasColor
+            ? gltf.readFloats(attributes.value(QLatin1String("COLOR_0")).toInt(), &colorComponents) : QVector<float>();
+
+    if (uvComponents != 2 || uvs.size() < 2 * p.VertexCount)
+        uvComponents = 0;
+    if (colorComponents < 3 || colors.size() < colorComponents * p.VertexCount)
+        colorComponents = 0;
+
+    float factor[4];
+    unpackColor(material.Color, factor);
+
+    p.Bounds = VRBounds();
+    p.Vertices.resize(p.VertexCount);
+    for (int i = 0; i < p.VertexCount; ++i)
+    {
+        float c[4] = { factor[0], factor[1], factor[2], factor[3] };
+        for (int k = 0; k < colorComponents; ++k)
+            c[k] *= colors[colorComponents * i + k];
+
+        VRMeshFileVertex &v = p.Vertices[i];
+        v.X = positions[3 * i];
+        v.Y = positions[3 * i + 1];
+        v.Z = positions[3 * i + 2];
+        v.C = packColor(c);
+        v.U = uvComponents ? uvs[2 * i] : 0.0f;
+        v.V = uvComponents ? uvs[2 * i + 1] : 0.0f;
+        p.Bounds.expand(QVector3D(v.X, v.Y, v.Z));
+    }
+
+    if (job.Json.contains(QLatin1String("indices")))
+    {
+        const QVector<quint32> read = gltf.readIndices(job.Json.value(QLatin1String("indices")).toInt());
+        p.ConvertedIndices.reserve(read.size());
+        for (quint32 index : read)
+        {
+            if (index < quint32(p.VertexCount))
+                p.ConvertedIndices.append(index);
+        }
+        p.ConvertedIndices.resize(p.ConvertedIndices.size() - p.ConvertedIndices.size() % 3);
+    }
+    else
+    {
+        p.ConvertedIndices.resize(p.VertexCount - p.VertexCount % 3);
+        for (int i = 0; i < p.ConvertedIndices.size(); ++i)
+            p.ConvertedIndices[i] = quint32(i);
+    }
+
+    job.Valid = !p.ConvertedIndices.isEmpty();
+}
+
+} // namespace
+
+VRGltfImporter::VRGltfImporter()
+{
+    // Each import spreads its primitives over the global pool itself.
+    m_workers.setMaxThreadCount(2);
+}
+
+VRGltfImporter::~VRGltfImporter()
+{
+    m_workers.clear();
+    m_workers.waitForDone();
+}
+
+bool VRGltfImporter::isGltfFile(const QString &fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix();
+    return suffix.compare(QLatin1String("glb"), Qt::CaseInsensitive) == 0
+        || suffix.compare(QLatin1String("gltf"), Qt::CaseInsensitive) == 0;
+}
+
+int VRGltfImporter::load(const QString &fileName)
+{
+    const int request = m_nextRequest++;
+
+    m_workers.start([this, request, fileName]() {
+        Asset asset = import(fileName);
+        asset.Request = request;
+
+        QMutexLocker lock(&m_mutex);
+        m_finished.append(asset);
+    });
+
+    return request;
+}
+
+void VRGltfImporter::takeFinished(QVector<Asset> &assets)
+{
+    QMutexLocker lock(&m_mutex);
+    assets += m_finished;
+    m_finished.clear();
+}
+
+VRGltfImporter::Asset VRGltfImporter::import(const QString &fileName)
+{
+    Asset asset;
+    asset.FileName = fileName;
+
+    VRGltfFile gltf;
+    if (!gltf.open(fileName, &asset.Error))
+        return asset;
+    asset.Buffers = gltf.buffers();
+
+    const QJsonArray images = gltf.array("images");
+    for (const QJsonValue &value : images)
+    {
+        const QJsonObject json = value.toObject();
+        const QString uri = json.value(QLatin1String("uri")).toString();
+        Image image;
+
+        if (json.contains(QLatin1String("bufferView")))
+        {
+            const QJsonObject view = gltf.array("bufferViews").at(json.value(QLatin1String("bufferView")).toInt()).toObject();
+            const QByteArray buffer = asset.Buffers.value(view.value(QLatin1String("buffer")).toInt(-1));
+            image.Data = buffer.mid(view.value(QLatin1String("byteOffset")).toInt(), view.value(QLatin1String("byteLength")).toInt());
+        }
+        else if (uri.startsWith(QLatin1String("data:")))
+        {
+            image.Data = QByteArray::fromBase64(uri.mid(uri.indexOf(QLatin1Char(',')) + 1).toLatin1());
+        }
+        else if (!uri.isEmpty())
+        {
+            image.FileName = gltf.directory() + QLatin1Char('/') + QUrl::fromPercentEncoding(uri.toUtf8());
+        }
+        asset.Images.append(image);
+    }
+
+    const QJsonArray textures = gltf.array("textures");
+    for (const QJsonValue &value : gltf.array("materials"))
+    {
+        const QJsonObject pbr = value.toObject().value(QLatin1String("pbrMetallicRoughness")).toObject();
+        Material material;
+
+        const QJsonArray baseColor = pbr.value(QLatin1String("baseColorFactor")).toArray();
+        if (baseColor.size() == 4)
+        {
+            const float color[4] = { float(baseColor[0].toDouble()), float(baseColor[1].toDouble()),
+                                     float(baseColor[2].toDouble()), float(baseColor[3].toDouble()) };
+            material.Color = packColor(color);
+        }
+
+        if (pbr.contains(QLatin1String("baseColorTexture")))
+        {
+            const int texture = pbr.value(QLatin1String("baseColorTexture")).toObject().value(QLatin1String("index")).toInt(-1);
+            const int image = textures.at(texture).toObject().value(QLatin1String("source")).toInt(-1);
+            if (image >= 0 && image < asset.Images.size())
+                material.Image = image;
+        }
+        asset.Materials.append(material);
+    }
+
+    QVector<Job> jobs;
+    for (int root : gltf.sceneRoots())
+        collectNode(gltf, root, QMatrix4x4(), jobs, 0);
+
+    qint64 vertexCount = 0;
+    const QJsonArray accessors = gltf.array("accessors");
+    for (const Job &job : qAsConst(jobs))
+    {
+        const int position = job.Json.value(QLatin1String("attributes")).toObject().value(QLatin1String("POSITION")).toInt(-1);
+        vertexCount += accessors.at(position).toObject().value(QLatin1String("count")).toInt();
+    }
+
+    const QVector<Material> &materials = asset.Materials;
+    const auto parse = [&gltf, &materials](Job &job) { parsePrimitive(gltf, materials, job); };
+    if (jobs.size() > 1 && vertexCount >= kParallelVertexCount)
+        QtConcurrent::blockingMap(jobs, parse);
+    else
+        std::for_each(jobs.begin(), jobs.end(), parse);
+
+    asset.Views.resize(gltf.array("bufferViews").size());
+    const auto useView = [&](const VRGltfFile::Accessor &a) {
+        if (a.View < 0 || !asset.Views[a.View].isNull())
+            return;
+        const QJsonObject view = gltf.array("bufferViews").at(a.View).toObject();
+        const QByteArray &buffer = asset.Buffers[view.value(QLatin1String("buffer")).toInt()];
+        const int offset = view.value(QLatin1String("byteOffset")).toInt();
+        const int length = qMin(view.value(QLatin1String("byteLength")).toInt(), buffer.size() - offset);
+        asset.Views[a.View] = QByteArray::fromRawData(buffer.constData() + offset, length);
+    };
+
+    for (const Job &job : qAsConst(jobs))
+    {
+        if (!job.Valid)
+            continue;
+        if (job.Out.isStored())
+        {
+            useView(job.Out.Position);
+            useView(job.Out.TexCoord);
+            useView(job.Out.Indices);
+        }
+        asset.Primitives.append(job.Out);
+    }
+
+    if (asset.Primitives.isEmpty())
+        asset.Error = QStringLiteral("no triangle geometry in the default scene");
+    return asset;
+}
@@ -0,0 +1,99 @@
+#ifndef VRGLTFIMPORTER_H
+#define VRGLTFIMPORTER_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QMutex>
+#include <QtCore/QString>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+#include <QtGui/QMatrix4x4>
+
+#include "VRCulling.h"
+#include "VRGltfFile.h"
+#include "VRMeshFile.h"
+
+// Imports glTF 2.0 assets (.glb, or .gltf with its buffers) on worker
+// threads, into what the renderer needs to create models without parsing
+// anything itself.
+//
+// The node hierarchy of the default scene is flattened: every triangle list
+// primitive becomes one Primitive with the transform of its node relative to
+// the asset root. Primitives whose accessors OpenGL can read as stored refer
+// to buffer views, which the renderer uploads straight from the file's
+// bytes. Anything else (sparse or quantized positions, unindexed geometry,
+// vertex colors, which are linear in glTF and sRGB in the renderer) is
+// converted to the interleaved VRMeshFileVertex layout. Assets with many
+// vertices are parsed one primitive per task, in parallel.
+//
+// load() and takeFinished() are called from the render thread.
+class VRGltfImporter
+{
+public:
+    // An encoded image, decoded by VRTextureLoader. Unlike other textures
+    // it is uploaded top row first, glTF texture coordinates start there.
+    struct Image
+    {
+        QString    FileName;    // external file, when Data is empty
+        QByteArray Data;
+    };
+
+    struct Material
+    {
+        quint32 Color = 0xffffffff;     // baseColorFactor, sRGB encoded R, G, B, A bytes
+        int     Image = -1;             // baseColorTexture
+    };
+
+    struct Primitive
+    {
+        QMatrix4x4 Transform;           // node to asset root
+        int        Material = -1;
+        VRBounds   Bounds;              // own space
+        int        VertexCount = 0;
+
+        // Read as stored from Asset::Views when Position.View >= 0. A
+        // missing TexCoord has View -1; the color comes from the material.
+        VRGltfFile::Accessor Position;
+        VRGltfFile::Accessor TexCoord;
+        VRGltfFile::Accessor Indices;
+
+        // Otherwise converted, material color included.
+        QVector<VRMeshFileVertex> Vertices;
+        QVector<quint32>          ConvertedIndices;
+
+        bool isStored() const { return Position.View >= 0; }
+    };
+
+    struct Asset
+    {
+        int                 Request = 0;
+        QString             FileName;
+        QString             Error;      // empty on success
+        QVector<QByteArray> Buffers;
+        QVector<QByteArray> Views;      // raw data inside Buffers, null unless a stored primitive reads it
+        QVector<Image>      Images;
+        QVector<Material>   Materials;
+        QVector<Primitive>  Primitives;
+    };
+
+    VRGltfImporter();
+    ~VRGltfImporter();
+
+    static bool isGltfFile(const QString &fileName);
+
+    // Returns a request id matched by Asset::Request.
+    int load(const QString &fileName);
+
+    // Appends the assets imported since the last call.
+    void takeFinished(QVector<Asset> &assets);
+
+private:
+    static Asset import(const QString &fileName);
+
+    QThreadPool m_workers;
+    int m_nextRequest = 1;
+
+    QMutex m_mutex;
+    QVector<Asset> m_finished;
+};
+
+#endif // VRGLTFIMPORTER_H
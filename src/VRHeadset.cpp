@@ -5,14 +5,24 @@
 #include "VRRenderer.h"
 #include "VRWindow.h"
 
+namespace {
+
+// 360 Hz divides 72, 90 and 120 Hz refresh periods evenly, so every
+// headset sees the same number of steps per second, and whole steps per
+// frame.
+const double kStep = 1.0 / 360.0;
+const double kMaxElapsed = 0.25;
+
+} // namespace
+
 VRHeadset::VRHeadset(QQuickItem *parent)
     : QQuickItem(parent)
 {
     connect(this, &QQuickItem::windowChanged, this, &VRHeadset::handleWindowChanged, Qt::DirectConnection);
-    connect(this, &QQuickItem::xChanged, this, &VRHeadset::onXChanged, Qt::DirectConnection);
-    connect(this, &QQuickItem::yChanged, this, &VRHeadset::onYChanged, Qt::DirectConnection);
-    connect(this, &QQuickItem::zChanged, this, &VRHeadset::onZChanged, Qt::DirectConnection);
-    connect(this, &QQuickItem::rotationChanged, this, &VRHeadset::onRotationChanged, Qt::DirectConnection);
+    connect(this, &QQuickItem::xChanged, this, &VRHeadset::onPoseChanged, Qt::DirectConnection);
+    connect(this, &QQuickItem::yChanged, this, &VRHeadset::onPoseChanged, Qt::DirectConnection);
+    connect(this, &QQuickItem::zChanged, this, &VRHeadset::onPoseChanged, Qt::DirectConnection);
+    connect(this, &QQuickItem::rotationChanged, this, &VRHeadset::onPoseChanged, Qt::DirectConnection);
 }
 
 void VRHeadset::setAngularVelocity(const QVector3D &newAngularVelocity)
@@ -33,62 +43,107 @@ void VRHeadset::setLinearVelocity(const QVector3D &newLinearVelocity)
     }
 }
 
+// Runs on the render thread while the GUI thread is blocked, so the item
+// can be moved and the renderer's pose published without racing the GUI.
 void VRHeadset::sync()
 {
-    QVector3D offset = QQuaternion::fromAxisAndAngle(0, 1, 0, rotation() + m_angularVelocity.y()) * m_linearVelocity;
-
-    setX(x() + offset.x());
-    setY(y() + offset.y());
-    setZ(z() + offset.z());
-
-    setRotation(rotation() + m_angularVelocity.y());
-}
+    VRRenderer *renderer = m_vrWindow->renderer();
+    const double displayTime = renderer ? renderer->predictedDisplayTime() : -1.0;
+    if (displayTime < 0.0)
+    {
+        // No session yet, the renderer still needs to start where the item is.
+        updateRenderer();
+        return;
+    }
 
-void VRHeadset::handleWindowChanged(QQuickWindow *win)
-{
-    if (m_vrWindow)
+    // Somebody moved the item since the last frame (or this is the first
+    // one): carry on from there.
+    Motion itemPose;
+    itemPose.Position = QVector3D(x(), y(), z());
+    itemPose.Yaw = float(rotation());
+    if (m_lastDisplayTime < 0.0 || itemPose.Position != m_applied.Position || itemPose.Yaw != m_applied.Yaw)
     {
-        disconnect(m_vrWindow, &VRWindow::beforeRendering, this, &VRHeadset::sync);
+        m_previous = m_current = m_applied = itemPose;
+        m_accumulator = 0.0;
     }
 
-    m_vrWindow = qobject_cast<VRWindow *>(win);
+    // Display times advance by one refresh period per frame, whatever the
+    // headset's refresh rate; a stall moves the viewer at most kMaxElapsed.
+    const double elapsed = m_lastDisplayTime < 0.0 ? 0.0 : qBound(0.0, displayTime - m_lastDisplayTime, kMaxElapsed);
+    m_lastDisplayTime = displayTime;
 
-    if (m_vrWindow)
+    m_accumulator += elapsed;
+    while (m_accumulator >= kStep)
     {
-        connect(m_vrWindow, &VRWindow::beforeRendering, this, &VRHeadset::sync, Qt::DirectConnection);
-        m_vrWindow->renderer()->Orientation = QQuaternion::fromAxisAndAngle(0, 1, 0, rotation());
-        m_vrWindow->renderer()->Position = QVector3D(x(), y(), z());
+        m_previous = m_current;
+        step(m_current, float(kStep));
+        m_accumulator -= kStep;
     }
+
+    // Show the pose between the last two steps, so motion stays smooth when
+    // frames and steps don't line up.
+    const float alpha = float(m_accumulator / kStep);
+    Motion shown;
+    shown.Position = m_previous.Position + (m_current.Position - m_previous.Position) * alpha;
+    shown.Yaw = m_previous.Yaw + (m_current.Yaw - m_previous.Yaw) * alpha;
+
+    if (shown.Position != m_applied.Position || shown.Yaw != m_applied.Yaw)
+        applyPose(shown);
 }
 
-void VRHeadset::onXChanged()
+void VRHeadset::step(Motion &motion, float seconds) const
 {
-    if (m_vrWindow)
+    motion.Yaw += m_angularVelocity.y() * seconds;
+    motion.Position += QQuaternion::fromAxisAndAngle(0, 1, 0, motion.Yaw) * (m_linearVelocity * seconds);
+}
+
+// Sets the whole pose, then hands it to the renderer once rather than once
+// per changed property.
+void VRHeadset::applyPose(const Motion &motion)
+{
+    m_applying = true;
+    setPosition(QPointF(motion.Position.x(), motion.Position.y()));
+    setZ(motion.Position.z());
+    setRotation(motion.Yaw);
+    m_applying = false;
+
+    m_applied = motion;
+    updateRenderer();
+}
+
+void VRHeadset::updateRenderer()
+{
+    VRRenderer *renderer = m_vrWindow ? m_vrWindow->renderer() : nullptr;
+    if (renderer)
     {
-        m_vrWindow->renderer()->Position.setX(x());
+        VRPose pose;
+        pose.Orientation = QQuaternion::fromAxisAndAngle(0, 1, 0, rotation());
+        pose.Position = QVector3D(x(), y(), z());
+        renderer->setOriginPose(pose);
     }
 }
 
-void VRHeadset::onYChanged()
+void VRHeadset::handleWindowChanged(QQuickWindow *win)
 {
     if (m_vrWindow)
     {
-        m_vrWindow->renderer()->Position.setY(y());
+        disconnect(m_vrWindow, &VRWindow::beforeSynchronizing, this, &VRHeadset::sync);
     }
-}
 
-void VRHeadset::onZChanged()
-{
+    m_vrWindow = qobject_cast<VRWindow *>(win);
+    m_lastDisplayTime = -1.0;
+
     if (m_vrWindow)
     {
-        m_vrWindow->renderer()->Position.setZ(z());
+        connect(m_vrWindow, &VRWindow::beforeSynchronizing, this, &VRHeadset::sync, Qt::DirectConnection);
+        updateRenderer();
     }
 }
 
-void VRHeadset::onRotationChanged()
+void VRHeadset::onPoseChanged()
 {
-    if (m_vrWindow)
+    if (!m_applying)
     {
-        m_vrWindow->renderer()->Orientation = QQuaternion::fromAxisAndAngle(0, 1, 0, rotation());
+        updateRenderer();
     }
 }
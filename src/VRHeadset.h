@@ -7,6 +7,10 @@
 
 class VRWindow;
 
+// Moves the viewer through the scene. The item's x, y, z and rotation (the
+// yaw, in degrees) are the position and heading of the tracking origin, and
+// can be set directly to teleport. angularVelocity is in degrees per second
+// and linearVelocity in units per second along the current heading.
 class VRHeadset : public QQuickItem
 {
     Q_OBJECT
@@ -30,15 +34,29 @@ signals:
 private slots:
     void sync();
     void handleWindowChanged(QQuickWindow *win);
-    void onXChanged();
-    void onYChanged();
-    void onZChanged();
-    void onRotationChanged();
+    void onPoseChanged();
 private:
+    struct Motion
+    {
+        QVector3D Position;
+        float     Yaw = 0.0f;
+    };
+
+    void step(Motion &motion, float seconds) const;
+    void applyPose(const Motion &motion);
+    void updateRenderer();
 
     VRWindow *m_vrWindow = nullptr;
     QVector3D m_angularVelocity;
     QVector3D m_linearVelocity;
+
+    // Fixed step integration, driven by the predicted display time.
+    double m_lastDisplayTime = -1.0;
+    double m_accumulator = 0.0;
+    Motion m_previous;
+    Motion m_current;
+    Motion m_applied;       // what applyPose() last set, to notice teleports
+    bool m_applying = false;
 };
 
 #endif // VRHEADSET_H
@@ -0,0 +1,401 @@
+#include "VRKtxImage.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtGui/QOpenGLContext>
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT                 0x83F0
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT                0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT                0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT                0x8C4C
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT          0x8C4D
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT          0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM                   0x8E8C
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM             0x8E8D
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2                         0x9274
+#define GL_COMPRESSED_SRGB8_ETC2                        0x9275
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2     0x9276
+#define GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2    0x9277
+#define GL_COMPRESSED_RGBA8_ETC2_EAC                    0x9278
+#define GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC             0x9279
+#endif
+
+namespace {
+
+struct Format
+{
+    quint32 VkFormat;       // KTX 2 identifies formats by their Vulkan name
+    GLenum  GlFormat;
+    int     BlockBytes;     // per 4x4 block, 0 for RGBA8
+};
+
+const Format kFormats[] =
+{
+    { 131, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,              8 },   // BC1
+    { 132, GL_COMPRESSED_SRGB_S3TC_DXT1_EXT,             8 },
+    { 133, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,             8 },
+    { 134, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT,       8 },
+    { 137, GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,            16 },   // BC3
+    { 138, GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT,      16 },
+    { 145, GL_COMPRESSED_RGBA_BPTC_UNORM,               16 },   // BC7
+    { 146, GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM,         16 },
+    { 147, GL_COMPRESSED_RGB8_ETC2,                      8 },   // ETC2
+    { 148, GL_COMPRESSED_SRGB8_ETC2,                     8 },
+    { 149, GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2,  8 },
+    { 150, GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2, 8 },
+    { 151, GL_COMPRESSED_RGBA8_ETC2_EAC,                16 },
+    { 152, GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC,         16 },
+    {  37, GL_RGBA8,                                     0 },   // uncompressed
+    {  43, GL_SRGB8_ALPHA8,                              0 },
+};
+
+const Format *findVkFormat(quint32 vkFormat)
+{
+    for (const Format &format : kFormats)
+    {
+        if (format.VkFormat == vkFormat)
+            return &format;
+    }
+    return nullptr;
+}
+
+const Format *findGlFormat(GLenum glFormat)
+{
+    for (const Format &format : kFormats)
+    {
+        if (format.GlFormat == glFormat)
+            return &format;
+    }
+    return nullptr;
+}
+
+template<typename T>
+T readValue(const QByteArray &data, qsizetype offset)
+{
+    T value = 0;
+    if (offset >= 0 && offset + qsizetype(sizeof(T)) <= data.size())
+        memcpy(&value, data.constData() + offset, sizeof(T));
+    return value;
+}
+
+qsizetype levelBytes(const Format &format, const QSize &size)
+{
+    if (!format.BlockBytes)
+        return qsizetype(size.width()) * size.height() * 4;
+    return qsizetype((size.width() + 3) / 4) * ((size.height() + 3) / 4) * format.BlockBytes;
+}
+
+QSize levelSize(quint32 width, quint32 height, int level)
+{
+    return QSize(qMax(1u, width >> level), qMax(1u, height >> level));
+}
+
+// Value of a key in KTX key/value data. Each entry is its byte count then
+// the key and the value, NUL terminated, padded to 4 bytes.
+QByteArray findValue(const QByteArray &data, qsizetype offset, qsizetype bytes, const char *key)
+{
+    const qsizetype end = qMin(offset + bytes, qsizetype(data.size()));
+    while (offset + 4 <= end)
+    {
+        const qsizetype length = readValue<quint32>(data, offset);
+        const qsizetype entry = offset + 4;
+        if (entry + length > end)
+            break;
+
+        const QByteArray pair = QByteArray::fromRawData(data.constData() + entry, int(length));
+        const int separator = pair.indexOf('\0');
+        if (separator >= 0 && pair.left(separator) == key)
+        {
+            const QByteArray value = pair.mid(separator + 1);
+            const int nul = value.indexOf('\0');
+            return nul >= 0 ? value.left(nul) : value;
+        }
+        offset = entry + ((length + 3) & ~qsizetype(3));
+    }
+    return QByteArray();
+}
+
+bool isBc1(GLenum format)
+{
+    return format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ||
+           format == GL_COMPRESSED_SRGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+}
+
+bool isBc3(GLenum format)
+{
+    return format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT || format == GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+}
+
+// BC7 and ETC2 blocks don't store their pixels row by row, and blocks of a
+// level whose height isn't a multiple of 4 can't be moved without shifting
+// the image.
+bool canFlip(const Format &format, const QSize &size)
+{
+    if (!format.BlockBytes)
+        return true;
+    return (isBc1(format.GlFormat) || isBc3(format.GlFormat)) && (size.height() < 4 || size.height() % 4 == 0);
+}
+
+// Reverses the first rows of a BC1 color block: one byte of 2 bit
+// indices per row after the two end point colors.
+void flipBc1Block(uchar *block, int rows)
+{
+    std::reverse(block + 4, block + 4 + rows);
+}
+
+// Reverses the first rows of a BC3 alpha block: 12 bits of 3 bit indices
+// per row after the two end point alphas.
+void flipBc3AlphaBlock(uchar *block, int rows)
+{
+    quint64 bits = 0;
+    for (int i = 0; i < 6; ++i)
+        bits |= quint64(block[2 + i]) << (8 * i);
+
+    quint64 flipped = bits;
+    for (int row = 0; row < rows; ++row)
+    {
+        const int to = 12 * (rows - 1 - row);
+        flipped &= ~(quint64(0xfff) << to);
+        flipped |= ((bits >> (12 * row)) & 0xfff) << to;
+    }
+
+    for (int i = 0; i < 6; ++i)
+        block[2 + i] = uchar(flipped >> (8 * i));
+}
+
+// Turns a level stored top row first into bottom row first, in place.
+void flipLevel(const Format &format, const QSize &size, uchar *pixels)
+{
+    const int blockSize = format.BlockBytes ? 4 : 1;
+    const qsizetype rowBytes = format.BlockBytes ? qsizetype((size.width() + 3) / 4) * format.BlockBytes : qsizetype(size.width()) * 4;
+    const int rows = (size.height() + blockSize - 1) / blockSize;
+
+    for (int row = 0; row < rows / 2; ++row)
+        std::swap_ranges(pixels + row * rowBytes, pixels + (row + 1) * rowBytes, pixels + (rows - 1 - row) * rowBytes);
+
+    if (!format.BlockBytes)
+        return;
+
+    const int blockRows = qMin(size.height(), 4);
+    for (uchar *block = pixels; block < pixels + rows * rowBytes; block += format.BlockBytes)
+    {
+        if (isBc3(format.GlFormat))
+        {
+            flipBc3AlphaBlock(block, blockRows);
+            flipBc1Block(block + 8, blockRows);
+        }
+        else
+        {
+            flipBc1Block(block, blockRows);
+        }
+    }
+}
+
+const char kKtx1Identifier[12] = { '\xAB', 'K', 'T', 'X', ' ', '1', '1', '\xBB', '\r', '\n', '\x1A', '\n' };
+const char kKtx2Identifier[12] = { '\xAB', 'K', 'T', 'X', ' ', '2', '0', '\xBB', '\r', '\n', '\x1A', '\n' };
+
+} // namespace
+
+QVector<GLenum> VRKtxImage::supportedFormats(QOpenGLContext *context)
+{
+    QVector<GLenum> formats = { GL_RGBA8, GL_SRGB8_ALPHA8 };
+
+    const QSurfaceFormat version = context->format();
+    const bool es3 = context->isOpenGLES() && version.majorVersion() >= 3;
+    const bool gl42 = !context->isOpenGLES() && version.version() >= qMakePair(4, 2);
+    const bool gl43 = !context->isOpenGLES() && version.version() >= qMakePair(4, 3);
+
+    if (context->hasExtension("GL_EXT_texture_compression_s3tc"))
+    {
+        formats << GL_COMPRESSED_RGB_S3TC_DXT1_EXT << GL_COMPRESSED_RGBA_S3TC_DXT1_EXT << GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        if (context->hasExtension("GL_EXT_texture_sRGB") || context->hasExtension("GL_EXT_texture_compression_s3tc_srgb"))
+            formats << GL_COMPRESSED_SRGB_S3TC_DXT1_EXT << GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT << GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+    }
+
+    if (gl42 || context->hasExtension("GL_ARB_texture_compression_bptc") || context->hasExtension("GL_EXT_texture_compression_bptc"))
+        formats << GL_COMPRESSED_RGBA_BPTC_UNORM << GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+
+    if (es3 || gl43 || context->hasExtension("GL_ARB_ES3_compatibility"))
+    {
+        formats << GL_COMPRESSED_RGB8_ETC2 << GL_COMPRESSED_SRGB8_ETC2
+                << GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 << GL_COMPRESSED_SRGB8_PUNCHTHROUGH_ALPHA1_ETC2
+                << GL_COMPRESSED_RGBA8_ETC2_EAC << GL_COMPRESSED_SRGB8_ALPHA8_ETC2_EAC;
+    }
+
+    return formats;
+}
+
+bool VRKtxImage::isKtxFile(const QString &fileName)
+{
+    const QString suffix = QFileInfo(fileName).suffix().toLower();
+    return suffix == QLatin1String("ktx") || suffix == QLatin1String("ktx2");
+}
+
+VRKtxImage VRKtxImage::read(const QString &fileName, QString *error)
+{
+    VRKtxImage image;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        *error = file.errorString();
+        return image;
+    }
+    image.Data = file.readAll();
+    const QByteArray &data = image.Data;
+
+    const Format *format = nullptr;
+    quint32 width = 0;
+    quint32 height = 0;
+    bool topRowFirst = true;
+
+    if (data.startsWith(QByteArray::fromRawData(kKtx2Identifier, sizeof(kKtx2Identifier))))
+    {
+        const quint32 vkFormat = readValue<quint32>(data, 12);
+        width = readValue<quint32>(data, 20);
+        height = readValue<quint32>(data, 24);
+        const quint32 depth = readValue<quint32>(data, 28);
+        const quint32 layers = readValue<quint32>(data, 32);
+        const quint32 faces = readValue<quint32>(data, 36);
+        const quint32 levels = qMax(1u, readValue<quint32>(data, 40));
+        const quint32 supercompression = readValue<quint32>(data, 44);
+        const quint32 keyValueOffset = readValue<quint32>(data, 56);
+        const quint32 keyValueBytes = readValue<quint32>(data, 60);
+
+        if (depth > 1 || layers > 1 || faces != 1 || supercompression != 0)
+        {
+            *error = QStringLiteral("only single 2D images without supercompression are supported");
+            return VRKtxImage();
+        }
+
+        format = findVkFormat(vkFormat);
+        if (!format)
+        {
+            *error = QStringLiteral("unsupported VkFormat %1").arg(vkFormat);
+            return VRKtxImage();
+        }
+
+        // Top left is the origin unless the orientation says otherwise,
+        // "ru" for a file stored bottom row first.
+        const QByteArray orientation = findValue(data, keyValueOffset, keyValueBytes, "KTXorientation");
+        topRowFirst = orientation.size() < 2 || orientation.at(1) != 'u';
+
+        // The level index follows the 80 byte header, largest level first.
+        for (quint32 level = 0; level < levels && level < 32; ++level)
+        {
+            const qsizetype entry = 80 + qsizetype(level) * 24;
+            image.Levels.append({ levelSize(width, height, int(level)),
+                                  qsizetype(readValue<quint64>(data, entry)),
+                                  qsizetype(readValue<quint64>(data, entry + 8)) });
+        }
+    }
+    else if (data.startsWith(QByteArray::fromRawData(kKtx1Identifier, sizeof(kKtx1Identifier))))
+    {
+        if (readValue<quint32>(data, 12) != 0x04030201)
+        {
+            *error = QStringLiteral("byte swapped files are not supported");
+            return VRKtxImage();
+        }
+
+        const GLenum glInternalFormat = readValue<quint32>(data, 28);
+        width = readValue<quint32>(data, 36);
+        height = readValue<quint32>(data, 40);
+        const quint32 depth = readValue<quint32>(data, 44);
+        const quint32 elements = readValue<quint32>(data, 48);
+        const quint32 faces = readValue<quint32>(data, 52);
+        const quint32 levels = qMax(1u, readValue<quint32>(data, 56));
+        const quint32 keyValueBytes = readValue<quint32>(data, 60);
+
+        if (depth > 1 || elements > 0 || faces != 1)
+        {
+            *error = QStringLiteral("only single 2D images are supported");
+            return VRKtxImage();
+        }
+
+        format = findGlFormat(glInternalFormat);
+        if (!format)
+        {
+            *error = QStringLiteral("unsupported internal format 0x%1").arg(glInternalFormat, 0, 16);
+            return VRKtxImage();
+        }
+
+        // "S=r,T=u" for a file stored bottom row first, top row first when
+        // the key is missing.
+        topRowFirst = !findValue(data, 64, keyValueBytes, "KTXorientation").contains("T=u");
+
+        // Each level is its byte count followed by the data, 4 byte aligned.
+        qsizetype offset = 64 + qsizetype(keyValueBytes);
+        for (quint32 level = 0; level < levels && level < 32; ++level)
+        {
+            const qsizetype length = readValue<quint32>(data, offset);
+            image.Levels.append({ levelSize(width, height, int(level)), offset + 4, length });
+            offset += 4 + ((length + 3) & ~qsizetype(3));
+        }
+    }
+    else
+    {
+        *error = QStringLiteral("not a KTX file");
+        return VRKtxImage();
+    }
+
+    if (!width || !height)
+    {
+        *error = QStringLiteral("empty image");
+        return VRKtxImage();
+    }
+
+    // Keeps levelBytes() from overflowing, no GPU samples anything larger.
+    if (width > 65536 || height > 65536)
+    {
+        *error = QStringLiteral("image too large");
+        return VRKtxImage();
+    }
+
+    for (const Level &level : qAsConst(image.Levels))
+    {
+        // KTX 2 offsets and lengths are 64 bit, they can't be summed before
+        // the offset is known to lie inside the file.
+        if (level.Offset < 0 || level.Offset > data.size() || level.Length < levelBytes(*format, level.Size)
+            || level.Length > data.size() - level.Offset)
+        {
+            *error = QStringLiteral("truncated file");
+            return VRKtxImage();
+        }
+    }
+
+    // OpenGL starts with the bottom row, like the images VRTextureLoader
+    // mirrors. Files that start with the top row are flipped when their
+    // format allows it.
+    if (topRowFirst)
+    {
+        bool flippable = true;
+        for (const Level &level : qAsConst(image.Levels))
+            flippable = flippable && canFlip(*format, level.Size);
+
+        if (flippable)
+        {
+            uchar *pixels = reinterpret_cast<uchar *>(image.Data.data());
+            for (const Level &level : qAsConst(image.Levels))
+                flipLevel(*format, level.Size, pixels + level.Offset);
+        }
+        else
+        {
+            qWarning("%s stores its top row first and its format can't be flipped, it will appear upside down. "
+                     "Write it bottom row first, for example with toktx --lower_left_maps_to_s0t0.", qPrintable(fileName));
+        }
+    }
+
+    image.InternalFormat = format->GlFormat;
+    image.Compressed = format->BlockBytes != 0;
+    return image;
+}
@@ -0,0 +1,43 @@
+#ifndef VRKTXIMAGE_H
+#define VRKTXIMAGE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QSize>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtGui/qopengl.h>
+
+class QOpenGLContext;
+
+// Mip chain of a KTX 1 or KTX 2 file, kept as stored so it can be uploaded
+// without decoding: BC1, BC3, BC7 and ETC2 blocks, or RGBA8 pixels. Only
+// single 2D images are read, no arrays, cube maps or supercompression.
+// Levels are bottom row first; RGBA8, BC1 and BC3 files stored top row
+// first, as their KTXorientation says, are flipped on reading.
+struct VRKtxImage
+{
+    struct Level
+    {
+        QSize     Size;
+        qsizetype Offset;   // into Data
+        qsizetype Length;
+    };
+
+    GLenum         InternalFormat = 0;
+    bool           Compressed = false;
+    QByteArray     Data;
+    QVector<Level> Levels;  // largest first
+
+    bool isNull() const { return Levels.isEmpty(); }
+
+    // Formats the context can sample, RGBA8 included.
+    static QVector<GLenum> supportedFormats(QOpenGLContext *context);
+
+    // By file name suffix, .ktx or .ktx2.
+    static bool isKtxFile(const QString &fileName);
+
+    // Returns a null image and sets error when the file can't be used.
+    static VRKtxImage read(const QString &fileName, QString *error);
+};
+
+#endif // VRKTXIMAGE_H
@@ -0,0 +1,27 @@
+#include "VRMaterial.h"
+
+VRMaterial::VRMaterial(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void VRMaterial::setPattern(Pattern newPattern)
+{
+    if (newPattern < Floor || newPattern >= PatternCount)
+        newPattern = Blank;
+
+    if (m_pattern != newPattern)
+    {
+        m_pattern = newPattern;
+        emit patternChanged(newPattern);
+    }
+}
+
+void VRMaterial::setSource(const QUrl &newSource)
+{
+    if (m_source != newSource)
+    {
+        m_source = newSource;
+        emit sourceChanged(newSource);
+    }
+}
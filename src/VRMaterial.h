@@ -0,0 +1,45 @@
+#ifndef VRMATERIAL_H
+#define VRMATERIAL_H
+
+#include <QObject>
+#include <QUrl>
+
+// Surface of a VRModel. The patterns are the procedural grid textures of the
+// room sample; vertex colors come from the model's boxes. An image source
+// replaces the pattern. It is decoded and uploaded in the background, models
+// show untextured until it is ready.
+class VRMaterial : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(Pattern pattern READ pattern WRITE setPattern NOTIFY patternChanged)
+    Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
+
+public:
+    enum Pattern
+    {
+        Floor,
+        Wall,
+        Ceiling,
+        Blank,
+        PatternCount
+    };
+    Q_ENUM(Pattern)
+
+    explicit VRMaterial(QObject *parent = nullptr);
+
+    Pattern pattern() const { return m_pattern; }
+    void setPattern(Pattern newPattern);
+
+    const QUrl &source() const { return m_source; }
+    void setSource(const QUrl &newSource);
+
+signals:
+    void patternChanged(Pattern);
+    void sourceChanged(const QUrl &);
+
+private:
+    Pattern m_pattern = Blank;
+    QUrl m_source;
+};
+
+#endif // VRMATERIAL_H
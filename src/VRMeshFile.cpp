@@ -0,0 +1,132 @@
+#include "VRMeshFile.h"
+
+#include <QtCore/QSaveFile>
+
+#include <cfloat>
+#include <cstring>
+
+static const char kMagic[8] = { 'Q', 'V', 'R', 'M', 'E', 'S', 'H', '\0' };
+
+static quint64 alignBlock(quint64 offset)
+{
+    return (offset + 15) & ~quint64(15);
+}
+
+bool VRMeshFile::open(const QString &fileName, QString *error)
+{
+    close();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        *error = m_file.errorString();
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    m_map = m_file.map(0, size);
+    if (m_map)
+    {
+        m_data = m_map;
+    }
+    else
+    {
+        // Compressed resources and some file systems can't be mapped.
+        m_copy = m_file.readAll();
+        m_data = reinterpret_cast<const uchar *>(m_copy.constData());
+    }
+
+    if (size < qint64(sizeof(VRMeshFileHeader)))
+    {
+        *error = QStringLiteral("truncated file");
+        close();
+        return false;
+    }
+    memcpy(&m_header, m_data, sizeof(m_header));
+
+    if (memcmp(m_header.Magic, kMagic, sizeof(kMagic)) != 0 || m_header.Version != kVersion)
+    {
+        *error = QStringLiteral("not a version %1 QuickVR mesh").arg(kVersion);
+        close();
+        return false;
+    }
+
+    // Offsets are compared before sizes, so that a huge one can't wrap the
+    // sum around and pass.
+    if ((m_header.IndexSize != 2 && m_header.IndexSize != 4)
+        || m_header.IndexCount % 3
+        || m_header.VertexOffset % 16 || m_header.IndexOffset % 16
+        || m_header.VertexOffset > quint64(size) || quint64(vertexBytes()) > quint64(size) - m_header.VertexOffset
+        || m_header.IndexOffset > quint64(size) || quint64(indexBytes()) > quint64(size) - m_header.IndexOffset)
+    {
+        *error = QStringLiteral("corrupt header");
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void VRMeshFile::close()
+{
+    if (m_map)
+    {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_file.close();
+    m_copy.clear();
+    m_data = nullptr;
+    m_header = VRMeshFileHeader();
+}
+
+bool VRMeshFile::write(const QString &fileName, const QVector<VRMeshFileVertex> &vertices,
+                       const QVector<quint32> &indices, QString *error)
+{
+    VRMeshFileHeader header = {};
+    memcpy(header.Magic, kMagic, sizeof(kMagic));
+    header.Version = kVersion;
+    header.IndexSize = vertices.size() <= 0x10000 ? 2 : 4;
+    header.VertexCount = quint32(vertices.size());
+    header.IndexCount = quint32(indices.size());
+    header.VertexOffset = alignBlock(sizeof(header));
+    header.IndexOffset = alignBlock(header.VertexOffset + quint64(vertices.size()) * sizeof(VRMeshFileVertex));
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        header.BoundsMin[axis] = vertices.isEmpty() ? 0.0f : FLT_MAX;
+        header.BoundsMax[axis] = vertices.isEmpty() ? 0.0f : -FLT_MAX;
+    }
+    for (const VRMeshFileVertex &v : vertices)
+    {
+        const float pos[3] = { v.X, v.Y, v.Z };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            header.BoundsMin[axis] = qMin(header.BoundsMin[axis], pos[axis]);
+            header.BoundsMax[axis] = qMax(header.BoundsMax[axis], pos[axis]);
+        }
+    }
+
+    QByteArray data(int(header.IndexOffset + quint64(indices.size()) * header.IndexSize), '\0');
+    memcpy(data.data(), &header, sizeof(header));
+    memcpy(data.data() + header.VertexOffset, vertices.constData(), size_t(vertices.size()) * sizeof(VRMeshFileVertex));
+
+    if (header.IndexSize == 2)
+    {
+        quint16 *out = reinterpret_cast<quint16 *>(data.data() + header.IndexOffset);
+        for (quint32 index : indices)
+            *out++ = quint16(index);
+    }
+    else
+    {
+        memcpy(data.data() + header.IndexOffset, indices.constData(), size_t(indices.size()) * sizeof(quint32));
+    }
+
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit())
+    {
+        *error = file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef VRMESHFILE_H
+#define VRMESHFILE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+// QuickVR binary mesh, *.qvrmesh, written by tools/meshconvert. Little
+// endian. The vertex and index blocks are laid out exactly like the
+// renderer's buffers, so loading is mapping the file and handing the blocks
+// to glBufferData:
+//
+//   VRMeshFileHeader
+//   VRMeshFileVertex[VertexCount]       at VertexOffset
+//   quint16 or quint32[IndexCount]      at IndexOffset, triangles
+//
+// Both blocks start on a 16 byte boundary.
+struct VRMeshFileHeader
+{
+    char    Magic[8];       // "QVRMESH\0"
+    quint32 Version;
+    quint32 IndexSize;      // 2 or 4 bytes
+    quint32 VertexCount;
+    quint32 IndexCount;
+    quint64 VertexOffset;
+    quint64 IndexOffset;
+    float   BoundsMin[3];
+    float   BoundsMax[3];
+};
+
+struct VRMeshFileVertex
+{
+    float   X, Y, Z;
+    quint32 C;              // R, G, B, A bytes in memory order
+    float   U, V;
+};
+
+class VRMeshFile
+{
+public:
+    static const quint32 kVersion = 1;
+
+    ~VRMeshFile() { close(); }
+
+    // Maps the file and checks that the blocks lie inside it.
+    bool open(const QString &fileName, QString *error);
+    void close();
+
+    const VRMeshFileHeader &header() const { return m_header; }
+    const void *vertices() const { return m_data + m_header.VertexOffset; }
+    qsizetype vertexBytes() const { return qsizetype(m_header.VertexCount) * sizeof(VRMeshFileVertex); }
+    const void *indices() const { return m_data + m_header.IndexOffset; }
+    qsizetype indexBytes() const { return qsizetype(m_header.IndexCount) * m_header.IndexSize; }
+
+    // Picks 16 bit indices when they are enough.
+    static bool write(const QString &fileName, const QVector<VRMeshFileVertex> &vertices,
+                      const QVector<quint32> &indices, QString *error);
+
+private:
+    QFile m_file;
+    uchar *m_map = nullptr;
+    QByteArray m_copy;      // when the file can't be mapped
+    const uchar *m_data = nullptr;
+    VRMeshFileHeader m_header = {};
+};
+
+#endif // VRMESHFILE_H
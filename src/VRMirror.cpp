@@ -0,0 +1,81 @@
+#include "VRMirror.h"
+
+#include <QSGSimpleTextureNode>
+
+#include "VRRenderer.h"
+#include "VRWindow.h"
+
+VRMirror::VRMirror(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    setFlag(ItemHasContents);
+    connect(this, &QQuickItem::windowChanged, this, &VRMirror::handleWindowChanged, Qt::DirectConnection);
+}
+
+// Runs on the render thread while the GUI thread is blocked, after
+// VRWindow::sync() recreated the mirror if needed, so the node below never
+// samples a deleted texture.
+void VRMirror::sync()
+{
+    VRRenderer *renderer = m_vrWindow->renderer();
+    const quint32 textureId = renderer ? renderer->mirrorTexture() : 0;
+    const QSize textureSize = renderer ? renderer->mirrorSize() : QSize();
+    if (textureId == m_textureId && textureSize == m_textureSize)
+        return;
+
+    m_textureId = textureId;
+    m_textureSize = textureSize;
+    m_textureChanged = true;
+    update();
+
+    QMetaObject::invokeMethod(this, [this, textureSize]() {
+        if (m_sourceSize != textureSize)
+        {
+            m_sourceSize = textureSize;
+            emit sourceSizeChanged(textureSize);
+        }
+    }, Qt::QueuedConnection);
+}
+
+QSGNode *VRMirror::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+{
+    QSGSimpleTextureNode *node = static_cast<QSGSimpleTextureNode *>(oldNode);
+    if (!m_textureId)
+    {
+        delete node;
+        return nullptr;
+    }
+
+    if (!node)
+    {
+        node = new QSGSimpleTextureNode;
+        node->setOwnsTexture(true);
+        node->setFiltering(QSGTexture::Linear);
+        m_textureChanged = true;
+    }
+
+    // The texture is top row first, like the ones the scene graph uploads
+    // from images, so it needs no flipping.
+    if (m_textureChanged)
+    {
+        node->setTexture(window()->createTextureFromNativeObject(QQuickWindow::NativeObjectTexture, &m_textureId, 0, m_textureSize));
+        m_textureChanged = false;
+    }
+    node->setRect(boundingRect());
+    return node;
+}
+
+void VRMirror::handleWindowChanged(QQuickWindow *win)
+{
+    if (m_vrWindow)
+    {
+        disconnect(m_vrWindow, &VRWindow::beforeSynchronizing, this, &VRMirror::sync);
+    }
+
+    m_vrWindow = qobject_cast<VRWindow *>(win);
+
+    if (m_vrWindow)
+    {
+        connect(m_vrWindow, &VRWindow::beforeSynchronizing, this, &VRMirror::sync, Qt::DirectConnection);
+    }
+}
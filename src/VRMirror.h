@@ -0,0 +1,42 @@
+#ifndef VRMIRROR_H
+#define VRMIRROR_H
+
+#include <QQuickItem>
+#include <QSize>
+
+class VRWindow;
+
+// Shows the desktop mirror of the VRWindow this item lives in, stretched
+// over the item. Set the window's mirrorInWindow to false to show it only
+// here. sourceSize is the size of the mirror texture, in pixels.
+class VRMirror : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(QSize sourceSize READ sourceSize NOTIFY sourceSizeChanged)
+
+public:
+    explicit VRMirror(QQuickItem *parent = nullptr);
+
+    QSize sourceSize() const { return m_sourceSize; }
+
+signals:
+    void sourceSizeChanged(const QSize &);
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *) override;
+
+private slots:
+    void sync();
+    void handleWindowChanged(QQuickWindow *win);
+
+private:
+    VRWindow *m_vrWindow = nullptr;
+    QSize m_sourceSize;
+
+    // Render thread.
+    quint32 m_textureId = 0;
+    QSize m_textureSize;
+    bool m_textureChanged = false;
+};
+
+#endif // VRMIRROR_H
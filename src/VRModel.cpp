@@ -0,0 +1,193 @@
+#include "VRModel.h"
+
+#include <QQmlFile>
+#include <QQuaternion>
+
+#include "VRBox.h"
+#include "VRWindow.h"
+
+static quint64 s_nextModelId = 1;
+
+VRModel::VRModel(QQuickItem *parent)
+    : QQuickItem(parent)
+    , m_id(s_nextModelId++)
+{
+    connect(this, &QQuickItem::windowChanged, this, &VRModel::handleWindowChanged, Qt::DirectConnection);
+}
+
+VRModel::~VRModel()
+{
+    if (m_vrWindow)
+    {
+        m_vrWindow->removeModel(this);
+    }
+}
+
+void VRModel::setPosition(const QVector3D &newPosition)
+{
+    if (m_position != newPosition)
+    {
+        m_position = newPosition;
+        markDirty(TransformDirty);
+        emit positionChanged(newPosition);
+    }
+}
+
+void VRModel::setEulerRotation(const QVector3D &newEulerRotation)
+{
+    if (m_eulerRotation != newEulerRotation)
+    {
+        m_eulerRotation = newEulerRotation;
+        markDirty(TransformDirty);
+        emit eulerRotationChanged(newEulerRotation);
+    }
+}
+
+void VRModel::setMaterial(VRMaterial *newMaterial)
+{
+    if (m_material != newMaterial)
+    {
+        if (m_material)
+        {
+            disconnect(m_material, nullptr, this, nullptr);
+        }
+
+        m_material = newMaterial;
+
+        if (m_material)
+        {
+            connect(m_material, &VRMaterial::patternChanged, this, &VRModel::markGeometryDirty);
+            connect(m_material, &VRMaterial::sourceChanged, this, &VRModel::markGeometryDirty);
+            connect(m_material, &QObject::destroyed, this, &VRModel::markGeometryDirty);
+        }
+
+        markDirty(GeometryDirty);
+        emit materialChanged(newMaterial);
+    }
+}
+
+void VRModel::setDynamic(bool newDynamic)
+{
+    if (m_dynamic != newDynamic)
+    {
+        m_dynamic = newDynamic;
+        markDirty(GeometryDirty);
+        emit dynamicChanged(newDynamic);
+    }
+}
+
+void VRModel::setInstanced(bool newInstanced)
+{
+    if (m_instanced != newInstanced)
+    {
+        m_instanced = newInstanced;
+        markDirty(GeometryDirty);
+        emit instancedChanged(newInstanced);
+    }
+}
+
+void VRModel::setSource(const QUrl &newSource)
+{
+    if (m_source != newSource)
+    {
+        m_source = newSource;
+        markDirty(GeometryDirty);
+        emit sourceChanged(newSource);
+    }
+}
+
+VRModelData VRModel::takeChanges()
+{
+    VRModelData data;
+    data.Id = m_id;
+
+    for (QQuickItem *item = parentItem(); item; item = item->parentItem())
+    {
+        if (VRModel *parent = qobject_cast<VRModel *>(item))
+        {
+            data.ParentId = parent->modelId();
+            break;
+        }
+    }
+
+    data.Transform.translate(m_position);
+    data.Transform.rotate(QQuaternion::fromEulerAngles(m_eulerRotation));
+
+    if (m_dirty & GeometryDirty)
+    {
+        data.GeometryChanged = true;
+        data.Pattern = m_material ? m_material->pattern() : VRMaterial::Blank;
+        if (m_material && !m_material->source().isEmpty())
+            data.Texture = QQmlFile::urlToLocalFileOrQrc(m_material->source());
+        data.Dynamic = m_dynamic;
+        data.Instanced = m_instanced;
+        if (!m_source.isEmpty())
+            data.Mesh = QQmlFile::urlToLocalFileOrQrc(m_source);
+
+        const QList<QQuickItem *> children = childItems();
+        for (QQuickItem *child : children)
+        {
+            if (VRBox *box = qobject_cast<VRBox *>(child))
+            {
+                data.Boxes.append({ box->from(), box->to(), box->color().rgba() });
+            }
+        }
+    }
+
+    m_dirty = 0;
+    return data;
+}
+
+void VRModel::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    if (change == ItemParentHasChanged)
+    {
+        markDirty(TransformDirty);
+    }
+    else if (change == ItemChildAddedChange || change == ItemChildRemovedChange)
+    {
+        if (VRBox *box = qobject_cast<VRBox *>(value.item))
+        {
+            if (change == ItemChildAddedChange)
+                connect(box, &VRBox::boxChanged, this, &VRModel::markGeometryDirty);
+            else
+                disconnect(box, &VRBox::boxChanged, this, &VRModel::markGeometryDirty);
+
+            markDirty(GeometryDirty);
+        }
+    }
+
+    QQuickItem::itemChange(change, value);
+}
+
+void VRModel::handleWindowChanged(QQuickWindow *win)
+{
+    if (m_vrWindow)
+    {
+        m_vrWindow->removeModel(this);
+    }
+
+    m_vrWindow = qobject_cast<VRWindow *>(win);
+
+    if (m_vrWindow)
+    {
+        m_dirty = TransformDirty | GeometryDirty;
+        m_vrWindow->addModel(this);
+    }
+}
+
+void VRModel::markGeometryDirty()
+{
+    markDirty(GeometryDirty);
+}
+
+void VRModel::markDirty(int flags)
+{
+    const bool wasDirty = m_dirty != 0;
+    m_dirty |= flags;
+
+    if (m_vrWindow && !wasDirty)
+    {
+        m_vrWindow->markModelDirty(this);
+    }
+}
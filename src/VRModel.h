@@ -0,0 +1,127 @@
+#ifndef VRMODEL_H
+#define VRMODEL_H
+
+#include <QMatrix4x4>
+#include <QPointer>
+#include <QQuickItem>
+#include <QUrl>
+#include <QVector>
+#include <QVector3D>
+
+#include "VRMaterial.h"
+
+class VRBox;
+class VRWindow;
+
+// Render thread copy of a VRModel, taken by VRWindow::sync(). Boxes are only
+// copied when the geometry changed since the previous copy.
+struct VRModelData
+{
+    struct Box
+    {
+        QVector3D From;
+        QVector3D To;
+        quint32   Color;    // 0xAARRGGBB
+    };
+
+    quint64      Id = 0;
+    quint64      ParentId = 0;  // closest VRModel ancestor, 0 for none
+    bool         Removed = false;
+    bool         GeometryChanged = false;
+    QMatrix4x4   Transform;     // relative to the parent model
+    int          Pattern = VRMaterial::Blank;
+    QString      Texture;   // image file replacing the pattern, if any
+    QString      Mesh;      // mesh or glTF file replacing the boxes, if any
+    bool         Dynamic = false;
+    bool         Instanced = false;
+    QVector<Box> Boxes;
+};
+
+// A mesh made of the VRBox items declared inside it, placed in the room by
+// position and eulerRotation (degrees). Models nested in another model are
+// placed relative to it and move with it. Property changes are only
+// recorded here; VRWindow hands them to the renderer in one batch per frame.
+//
+// Models are static by default: the renderer merges them with the other
+// static models of the same material into a single draw call, and moving
+// one means rebuilding that whole batch. Set dynamic for models that move.
+//
+// Instanced models draw every box as an instance of one shared unit cube,
+// a few bytes per box instead of 24 vertices and 36 indices. Use them for
+// large numbers of boxes.
+//
+// A source mesh file (*.qvrmesh, see tools/meshconvert) replaces the boxes.
+// It is mapped and uploaded as is, and always drawn on its own. A glTF 2.0
+// source (*.glb, *.gltf) is imported in the background into one mesh per
+// primitive, placed by its node hierarchy and textured by its own materials.
+class VRModel : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(QVector3D position READ position WRITE setPosition NOTIFY positionChanged)
+    Q_PROPERTY(QVector3D eulerRotation READ eulerRotation WRITE setEulerRotation NOTIFY eulerRotationChanged)
+    Q_PROPERTY(VRMaterial *material READ material WRITE setMaterial NOTIFY materialChanged)
+    Q_PROPERTY(bool dynamic READ isDynamic WRITE setDynamic NOTIFY dynamicChanged)
+    Q_PROPERTY(bool instanced READ isInstanced WRITE setInstanced NOTIFY instancedChanged)
+    Q_PROPERTY(QUrl source READ source WRITE setSource NOTIFY sourceChanged)
+
+public:
+    explicit VRModel(QQuickItem *parent = nullptr);
+    ~VRModel() override;
+
+    const QVector3D &position() const { return m_position; }
+    const QVector3D &eulerRotation() const { return m_eulerRotation; }
+    VRMaterial *material() const { return m_material; }
+    bool isDynamic() const { return m_dynamic; }
+    bool isInstanced() const { return m_instanced; }
+    const QUrl &source() const { return m_source; }
+
+    void setPosition(const QVector3D &newPosition);
+    void setEulerRotation(const QVector3D &newEulerRotation);
+    void setMaterial(VRMaterial *newMaterial);
+    void setDynamic(bool newDynamic);
+    void setInstanced(bool newInstanced);
+    void setSource(const QUrl &newSource);
+
+    quint64 modelId() const { return m_id; }
+
+    // Called by VRWindow::sync() while the GUI thread is blocked.
+    VRModelData takeChanges();
+    void detachWindow() { m_vrWindow = nullptr; }
+
+signals:
+    void positionChanged(const QVector3D &);
+    void eulerRotationChanged(const QVector3D &);
+    void materialChanged(VRMaterial *);
+    void dynamicChanged(bool);
+    void instancedChanged(bool);
+    void sourceChanged(const QUrl &);
+
+protected:
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+
+private slots:
+    void handleWindowChanged(QQuickWindow *win);
+    void markGeometryDirty();
+
+private:
+    enum DirtyFlag
+    {
+        TransformDirty = 0x1,
+        GeometryDirty  = 0x2
+    };
+
+    void markDirty(int flags);
+
+    VRWindow *m_vrWindow = nullptr;
+    quint64 m_id;
+    int m_dirty = TransformDirty | GeometryDirty;
+
+    QVector3D m_position;
+    QVector3D m_eulerRotation;
+    QPointer<VRMaterial> m_material;
+    bool m_dynamic = false;
+    bool m_instanced = false;
+    QUrl m_source;
+};
+
+#endif // VRMODEL_H
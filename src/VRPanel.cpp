@@ -0,0 +1,109 @@
+#include "VRPanel.h"
+
+#include <QQmlProperty>
+#include <QQuaternion>
+
+#include "VRWindow.h"
+
+static quint64 s_nextPanelId = 1;
+
+VRPanel::VRPanel(QQuickItem *parent)
+    : QQuickItem(parent)
+    , m_id(s_nextPanelId++)
+{
+    connect(this, &QQuickItem::windowChanged, this, &VRPanel::handleWindowChanged, Qt::DirectConnection);
+}
+
+VRPanel::~VRPanel()
+{
+    if (m_vrWindow)
+    {
+        m_vrWindow->removePanel(this);
+    }
+}
+
+void VRPanel::setPosition(const QVector3D &newPosition)
+{
+    if (m_position != newPosition)
+    {
+        m_position = newPosition;
+        requestSync();
+        emit positionChanged(newPosition);
+    }
+}
+
+void VRPanel::setEulerRotation(const QVector3D &newEulerRotation)
+{
+    if (m_eulerRotation != newEulerRotation)
+    {
+        m_eulerRotation = newEulerRotation;
+        requestSync();
+        emit eulerRotationChanged(newEulerRotation);
+    }
+}
+
+void VRPanel::setQuadWidth(qreal newQuadWidth)
+{
+    if (m_quadWidth != newQuadWidth)
+    {
+        m_quadWidth = newQuadWidth;
+        requestSync();
+        emit quadWidthChanged(newQuadWidth);
+    }
+}
+
+void VRPanel::setHeadLocked(bool newHeadLocked)
+{
+    if (m_headLocked != newHeadLocked)
+    {
+        m_headLocked = newHeadLocked;
+        requestSync();
+        emit headLockedChanged(newHeadLocked);
+    }
+}
+
+// The layer tracks the children; the pose is only read by VRWindow::sync().
+void VRPanel::requestSync()
+{
+    if (m_vrWindow)
+    {
+        m_vrWindow->update();
+    }
+}
+
+VRPanelData VRPanel::panelData()
+{
+    VRPanelData data;
+    data.Id = m_id;
+    data.Provider = textureProvider();
+    data.Pose.Position = m_position;
+    data.Pose.Orientation = QQuaternion::fromEulerAngles(m_eulerRotation);
+    data.Width = float(m_quadWidth);
+    data.HeadLocked = m_headLocked;
+    return data;
+}
+
+void VRPanel::componentComplete()
+{
+    QQuickItem::componentComplete();
+
+    // The same as layer.enabled: true in QML. The layer re-renders the
+    // children only when they change, and its texture provider tells the
+    // renderer when it did.
+    QQmlProperty(this, QStringLiteral("layer.enabled")).write(true);
+}
+
+void VRPanel::handleWindowChanged(QQuickWindow *win)
+{
+    if (m_vrWindow)
+    {
+        m_vrWindow->removePanel(this);
+    }
+
+    m_vrWindow = qobject_cast<VRWindow *>(win);
+
+    if (m_vrWindow)
+    {
+        m_vrWindow->addPanel(this);
+    }
+}
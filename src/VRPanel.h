@@ -0,0 +1,84 @@
+#ifndef VRPANEL_H
+#define VRPANEL_H
+
+#include <QQuickItem>
+#include <QVector3D>
+
+#include "VRBackend.h"
+
+class QSGTextureProvider;
+class VRWindow;
+
+// Render thread copy of a VRPanel, taken by VRWindow::sync() every frame.
+struct VRPanelData
+{
+    quint64              Id = 0;
+    QSGTextureProvider * Provider = nullptr;   // the item's layer
+    VRPose               Pose;                  // in the scene, or relative to the head
+    float                Width = 1.0f;
+    bool                 HeadLocked = false;
+};
+
+// Shows the Qt Quick items declared inside it in the headset, as a
+// rectangle quadWidth wide placed in the room by position and eulerRotation
+// (degrees), or relative to the head when headLocked. Its width and height
+// are the resolution, in pixels, of the texture the items are rendered to.
+//
+// The items are rendered into the item's layer, only when they change, and
+// the compositor draws that texture over the eye buffers as a quad layer:
+// it samples it once at display resolution, sharper than drawing it into
+// both eye buffers, and nothing is redrawn while it doesn't change. The
+// panel also shows in the window where it sits; place it outside the
+// window to keep it out of the desktop view.
+class VRPanel : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(QVector3D position READ position WRITE setPosition NOTIFY positionChanged)
+    Q_PROPERTY(QVector3D eulerRotation READ eulerRotation WRITE setEulerRotation NOTIFY eulerRotationChanged)
+    Q_PROPERTY(qreal quadWidth READ quadWidth WRITE setQuadWidth NOTIFY quadWidthChanged)
+    Q_PROPERTY(bool headLocked READ headLocked WRITE setHeadLocked NOTIFY headLockedChanged)
+
+public:
+    explicit VRPanel(QQuickItem *parent = nullptr);
+    ~VRPanel() override;
+
+    const QVector3D &position() const { return m_position; }
+    const QVector3D &eulerRotation() const { return m_eulerRotation; }
+    qreal quadWidth() const { return m_quadWidth; }
+    bool headLocked() const { return m_headLocked; }
+
+    void setPosition(const QVector3D &newPosition);
+    void setEulerRotation(const QVector3D &newEulerRotation);
+    void setQuadWidth(qreal newQuadWidth);
+    void setHeadLocked(bool newHeadLocked);
+
+    // Called by VRWindow::sync() on the render thread while the GUI thread
+    // is blocked.
+    VRPanelData panelData();
+    void detachWindow() { m_vrWindow = nullptr; }
+
+signals:
+    void positionChanged(const QVector3D &);
+    void eulerRotationChanged(const QVector3D &);
+    void quadWidthChanged(qreal);
+    void headLockedChanged(bool);
+
+protected:
+    void componentComplete() override;
+
+private slots:
+    void handleWindowChanged(QQuickWindow *win);
+
+private:
+    void requestSync();
+
+    VRWindow *m_vrWindow = nullptr;
+    quint64 m_id;
+
+    QVector3D m_position;
+    QVector3D m_eulerRotation;
+    qreal m_quadWidth = 1.0;
+    bool m_headLocked = false;
+};
+
+#endif // VRPANEL_H
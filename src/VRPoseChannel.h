@@ -0,0 +1,45 @@
+#ifndef VRPOSECHANNEL_H
+#define VRPOSECHANNEL_H
+
+#include <atomic>
+
+#include "VRBackend.h"
+
+// Hands whole poses from one writer to one reader without locks: a triple
+// buffer. The writer fills a slot of its own and swaps it with the shared
+// one, the reader swaps the shared slot with its own when something new was
+// published. Neither side ever waits, and the reader always sees a complete
+// pose, the latest one at the time of its swap.
+//
+// There may be several writing threads as long as they don't publish
+// concurrently, e.g. the GUI thread and the render thread while it
+// synchronizes with the GUI thread blocked.
+class VRPoseChannel
+{
+public:
+    void publish(const VRPose &pose)
+    {
+        m_slots[m_back] = pose;
+        m_back = m_shared.exchange(m_back | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // The latest published pose, or the one returned last time when nothing
+    // was published since.
+    const VRPose &latest()
+    {
+        if (m_shared.load(std::memory_order_relaxed) & kFresh)
+            m_front = m_shared.exchange(m_front, std::memory_order_acq_rel) & kIndexMask;
+        return m_slots[m_front];
+    }
+
+private:
+    static const int kIndexMask = 3;
+    static const int kFresh = 4;
+
+    VRPose m_slots[3];
+    int m_back = 0;                     // writer's slot
+    std::atomic<int> m_shared { 1 };    // slot index, kFresh when not read yet
+    int m_front = 2;                    // reader's slot
+};
+
+#endif // VRPOSECHANNEL_H
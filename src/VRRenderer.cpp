@@ -0,0 +1,3019 @@
+#include "VRRenderer.h"
+#include "VRCulling.h"
+#include "VRGltfImporter.h"
+#include "VRMeshFile.h"
+#include "VRSimd.h"
+#include "VRTextureLoader.h"
+#include "VRTransformHierarchy.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
+#include <QtCore/QSet>
+#include <QtCore/QtMath>
+#include <QtGui/QMatrix4x4>
+#include <QtGui/QVector2D>
+#include <QtQuick/QSGTextureProvider>
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#pragma comment(lib, "user32.lib")
+#endif
+
+#ifndef VALIDATE
+#if defined(_WIN32)
+#define VALIDATE(x, msg) if (!(x)) { MessageBoxA(nullptr, (msg), "QuickVR", MB_ICONERROR | MB_OK); exit(-1); }
+#else
+#define VALIDATE(x, msg) if (!(x)) { qFatal("QuickVR: %s", (msg)); }
+#endif
+#endif
+
+#ifndef GL_TEXTURE_SRGB_DECODE_EXT
+#define GL_TEXTURE_SRGB_DECODE_EXT 0x8A48
+#define GL_SKIP_DECODE_EXT         0x8A4A
+#endif
+
+static QSize ScaledSize(QSize size, float scale)
+{
+    return QSize(qMax(1, qRound(size.width() * scale)), qMax(1, qRound(size.height() * scale)));
+}
+
+// While the window is being resized the old mirror is stretched, it is
+// only recreated once the size held for this many frames.
+static const int kMirrorSettleFrames = 10;
+
+struct EyeTextureBuffer : protected QOpenGLExtraFunctions
+{
+    VRSwapChain       * SwapChain;
+    GLuint              fboId;
+    QSize               texSize;
+    QSize               viewportSize;   // drawn part, from the bottom left corner
+
+    EyeTextureBuffer(VRSwapChain * swapChain) :
+        SwapChain(swapChain),
+        fboId(0),
+        texSize(swapChain->size()),
+        viewportSize(texSize)
+    {
+        initializeOpenGLFunctions();
+        glGenFramebuffers(1, &fboId);
+    }
+
+    ~EyeTextureBuffer()
+    {
+        if (SwapChain)
+        {
+            delete SwapChain;
+            SwapChain = nullptr;
+        }
+        if (fboId)
+        {
+            glDeleteFramebuffers(1, &fboId);
+            fboId = 0;
+        }
+    }
+
+    QSize GetSize() const
+    {
+        return texSize;
+    }
+
+    QSize GetViewportSize() const
+    {
+        return viewportSize;
+    }
+
+    void SetViewportSize(QSize size)
+    {
+        viewportSize = size.boundedTo(texSize);
+    }
+
+    void SetAndClearRenderSurface()
+    {
+        GLuint curColorTexId = SwapChain->currentColorTexture();
+        GLuint curDepthTexId = SwapChain->currentDepthTexture();
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fboId);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, curColorTexId, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, curDepthTexId, 0);
+
+        // Only what the compositor will sample needs clearing.
+        glViewport(0, 0, viewportSize.width(), viewportSize.height());
+        glScissor(0, 0, viewportSize.width(), viewportSize.height());
+        glEnable(GL_SCISSOR_TEST);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glDisable(GL_SCISSOR_TEST);
+        glEnable(GL_FRAMEBUFFER_SRGB);
+    }
+
+    void UnsetRenderSurface()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, fboId);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    }
+
+    void Commit()
+    {
+        SwapChain->commit();
+    }
+};
+
+struct DepthBuffer : protected QOpenGLExtraFunctions
+{
+    GLuint        texId;
+
+    DepthBuffer(QSize size)
+    {
+        initializeOpenGLFunctions();
+        glGenTextures(1, &texId);
+        glBindTexture(GL_TEXTURE_2D, texId);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        GLenum internalFormat = GL_DEPTH_COMPONENT24;
+        GLenum type = GL_UNSIGNED_INT;
+        if (GL_ARB_depth_buffer_float)
+        {
+            internalFormat = GL_DEPTH_COMPONENT32F;
+            type = GL_FLOAT;
+        }
+
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, size.width(), size.height(), 0, GL_DEPTH_COMPONENT, type, NULL);
+    }
+    ~DepthBuffer()
+    {
+        if (texId)
+        {
+            glDeleteTextures(1, &texId);
+            texId = 0;
+        }
+    }
+};
+
+struct TextureBuffer : protected QOpenGLExtraFunctions
+{
+    GLuint              texId;
+    GLuint              fboId;
+    QSize               texSize;
+
+    TextureBuffer(bool rendertarget, QSize size, int mipLevels, unsigned char * data) :
+        texId(0),
+        fboId(0),
+        texSize(0, 0)
+    {
+        initializeOpenGLFunctions();
+        texSize = size;
+
+        glGenTextures(1, &texId);
+        glBindTexture(GL_TEXTURE_2D, texId);
+
+        if (rendertarget)
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        else
+        {
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        }
+
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, texSize.width(), texSize.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+
+        if (mipLevels > 1)
+        {
+            glGenerateMipmap(GL_TEXTURE_2D);
+        }
+
+        if(rendertarget)
+        {
+            glGenFramebuffers(1, &fboId);
+        }
+    }
+
+    ~TextureBuffer()
+    {
+        if (texId)
+        {
+            glDeleteTextures(1, &texId);
+            texId = 0;
+        }
+        if (fboId)
+        {
+            glDeleteFramebuffers(1, &fboId);
+            fboId = 0;
+        }
+    }
+
+    QSize GetSize() const
+    {
+        return texSize;
+    }
+
+    // Takes over a texture made elsewhere, VRTextureLoader's for instance.
+    void Replace(GLuint newTexId, QSize newSize)
+    {
+        if (texId)
+            glDeleteTextures(1, &texId);
+        texId = newTexId;
+        texSize = newSize;
+    }
+
+    void SetAndClearRenderSurface(DepthBuffer* dbuffer)
+    {
+        VALIDATE(fboId, "Texture wasn't created as a render target");
+
+        GLuint curTexId = texId;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fboId);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, curTexId, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, dbuffer->texId, 0);
+
+        glViewport(0, 0, texSize.width(), texSize.height());
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glEnable(GL_FRAMEBUFFER_SRGB);
+    }
+
+    void UnsetRenderSurface()
+    {
+        VALIDATE(fboId, "Texture wasn't created as a render target");
+
+        glBindFramebuffer(GL_FRAMEBUFFER, fboId);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, 0, 0);
+    }
+};
+
+// A linked program with the locations Model::Render needs resolved once at
+// link time, rather than looked up by name on every draw.
+struct ShaderProgram : protected QOpenGLExtraFunctions
+{
+    // Buffer binding points of the blocks FrameBuffers fills. The shaders
+    // declare ObjectBinding in their layout qualifier.
+    enum { CameraBinding = 0, ObjectBinding = 1 };
+
+    GLuint            program;
+    GLint             worldLoc;           // -1 when world matrices come from the object buffer
+    GLint             drawIdLoc;          // -1 unless they do
+    GLint             posLoc;
+    GLint             colorLoc;
+    GLint             uvLoc;
+    GLint             instanceOffsetLoc;  // -1 unless the program is instanced
+    GLint             instanceSizeLoc;
+    GLint             instanceColorLoc;
+    bool              linked;
+
+    ShaderProgram(GLuint vertexShader, GLuint pixelShader) :
+        worldLoc(-1),
+        drawIdLoc(-1),
+        posLoc(-1),
+        colorLoc(-1),
+        uvLoc(-1),
+        instanceOffsetLoc(-1),
+        instanceSizeLoc(-1),
+        instanceColorLoc(-1),
+        linked(false)
+    {
+        initializeOpenGLFunctions();
+
+        program = glCreateProgram();
+
+        glAttachShader(program, vertexShader);
+        glAttachShader(program, pixelShader);
+
+        glLinkProgram(program);
+
+        glDetachShader(program, vertexShader);
+        glDetachShader(program, pixelShader);
+
+        GLint r;
+        glGetProgramiv(program, GL_LINK_STATUS, &r);
+        if (!r)
+        {
+            GLchar msg[1024];
+            glGetProgramInfoLog(program, sizeof(msg), 0, msg);
+            qDebug("Linking shaders failed: %s\n", msg);
+            return;
+        }
+        linked = true;
+
+        worldLoc = glGetUniformLocation(program, "World");
+        drawIdLoc = glGetUniformLocation(program, "DrawId");
+        posLoc = glGetAttribLocation(program, "Position");
+        colorLoc = glGetAttribLocation(program, "Color");
+        uvLoc = glGetAttribLocation(program, "TexCoord");
+        instanceOffsetLoc = glGetAttribLocation(program, "InstanceOffset");
+        instanceSizeLoc = glGetAttribLocation(program, "InstanceSize");
+        instanceColorLoc = glGetAttribLocation(program, "InstanceColor");
+
+        const GLuint cameraBlock = glGetUniformBlockIndex(program, "Camera");
+        if (cameraBlock != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, cameraBlock, CameraBinding);
+
+        // Samplers never change unit, bind it once
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, "Texture0"), 0);
+        glUseProgram(0);
+    }
+
+    ~ShaderProgram()
+    {
+        if (program)
+        {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+};
+
+// The only way Scene::Render talks to OpenGL. Every call it makes goes
+// through here and is counted right where it is issued, so the draw
+// counters are what the driver actually saw. Also remembers what was last
+// bound so consecutive models sharing a program, texture or vertex array
+// don't rebind it. Only valid between Reset() and the end of
+// Scene::Render, the scene graph renderer is free to change any of it
+// outside.
+struct GLStateCache : protected QOpenGLExtraFunctions
+{
+    VRFrameStatistics::DrawCounters & Counters;
+    GLuint Program;
+    GLuint Texture;
+    GLuint VertexArray;
+
+    GLStateCache(VRFrameStatistics::DrawCounters & counters) :
+        Counters(counters),
+        Program(0),
+        Texture(0),
+        VertexArray(0)
+    {
+        initializeOpenGLFunctions();
+    }
+
+    void Reset()
+    {
+        glActiveTexture(GL_TEXTURE0);
+        Counters.StateChanges += 1;
+
+        Program = 0;
+        Texture = 0;
+        VertexArray = 0;
+    }
+
+    void Enable(GLenum capability)
+    {
+        glEnable(capability);
+        Counters.StateChanges += 1;
+    }
+
+    void Disable(GLenum capability)
+    {
+        glDisable(capability);
+        Counters.StateChanges += 1;
+    }
+
+    void DepthFunc(GLenum func)
+    {
+        glDepthFunc(func);
+        Counters.StateChanges += 1;
+    }
+
+    void BindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+    {
+        glBindBufferRange(target, index, buffer, offset, size);
+        Counters.StateChanges += 1;
+    }
+
+    void UseProgram(GLuint program)
+    {
+        if (Program != program)
+        {
+            glUseProgram(program);
+            Program = program;
+            Counters.StateChanges += 1;
+        }
+    }
+
+    void BindTexture(GLuint texture)
+    {
+        if (Texture != texture)
+        {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            Texture = texture;
+            Counters.StateChanges += 1;
+        }
+    }
+
+    void BindVertexArray(GLuint vertexArray)
+    {
+        if (VertexArray != vertexArray)
+        {
+            glBindVertexArray(vertexArray);
+            VertexArray = vertexArray;
+            Counters.StateChanges += 1;
+        }
+    }
+
+    void Uniform(GLint location, int value)
+    {
+        glUniform1i(location, value);
+        Counters.UniformUploads += 1;
+    }
+
+    void Uniform(GLint location, const QMatrix4x4 &value)
+    {
+        glUniformMatrix4fv(location, 1, GL_FALSE, value.constData());
+        Counters.UniformUploads += 1;
+    }
+
+    void DrawElements(GLsizei count, GLenum type, GLintptr offset, GLsizei instanceCount)
+    {
+        if (instanceCount > 1)
+            glDrawElementsInstanced(GL_TRIANGLES, count, type, (void*)offset, instanceCount);
+        else
+            glDrawElements(GL_TRIANGLES, count, type, (void*)offset);
+        Counters.DrawCalls += 1;
+    }
+};
+
+// Shader inputs that change once per frame rather than per draw.
+//
+// Camera is a uniform buffer with the eyes' view-projection matrices: one
+// block holding both in single pass stereo, one block per eye otherwise.
+//
+// With GL 4.3 and buffer storage, Objects holds the world matrix of every
+// model drawn this frame, in draw order, and shaders index it with the
+// DrawId uniform. It is a ring of RegionCount regions, mapped once,
+// persistently and coherently. A region is only written again after the
+// fence placed behind the frame that last used it signaled. Without it
+// models upload their World uniform on every draw instead.
+struct FrameBuffers : protected QOpenGLExtraFunctions
+{
+    static const int RegionCount = 3;
+
+    GLuint      CameraBuffer;
+    GLsizeiptr  CameraBytes;        // per block
+    GLsizeiptr  CameraStride;       // aligned for glBindBufferRange
+    bool        UseObjectBuffer;
+    GLuint      ObjectBuffer;       // created by the first MapObjects()
+    char      * ObjectMapping;
+    int         ObjectCapacity;     // matrices per region
+    GLsizeiptr  RegionStride;
+    int         Region;             // written this frame
+    GLsync      Fences[RegionCount];
+    PFNGLBUFFERSTORAGEPROC BufferStorage;
+
+    FrameBuffers() :
+        CameraBuffer(0),
+        CameraBytes(0),
+        CameraStride(0),
+        UseObjectBuffer(false),
+        ObjectBuffer(0),
+        ObjectMapping(nullptr),
+        ObjectCapacity(0),
+        RegionStride(0),
+        Region(0),
+        BufferStorage(nullptr)
+    {
+        initializeOpenGLFunctions();
+        memset(Fences, 0, sizeof(Fences));
+    }
+
+    ~FrameBuffers()
+    {
+        Release();
+    }
+
+    static GLsizeiptr Align(GLsizeiptr bytes, GLint alignment)
+    {
+        return alignment > 1 ? (bytes + alignment - 1) / alignment * alignment : bytes;
+    }
+
+    bool SupportsObjectBuffer()
+    {
+        QOpenGLContext * context = QOpenGLContext::currentContext();
+        const QSurfaceFormat format = context->format();
+        const int version = format.majorVersion() * 10 + format.minorVersion();
+        if (context->isOpenGLES() || version < 43 || (version < 44 && !context->hasExtension("GL_ARB_buffer_storage")))
+            return false;
+
+        BufferStorage = (PFNGLBUFFERSTORAGEPROC) context->getProcAddress("glBufferStorage");
+        return BufferStorage != nullptr;
+    }
+
+    void Init(int viewCount, bool objectBuffer)
+    {
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        CameraBytes = viewCount * 16 * sizeof(GLfloat);
+        CameraStride = Align(CameraBytes, alignment);
+
+        glGenBuffers(1, &CameraBuffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, CameraBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, 2 * CameraStride, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        UseObjectBuffer = objectBuffer;
+    }
+
+    void SetCamera(const QMatrix4x4 eyeViewProj[2])
+    {
+        glBindBuffer(GL_UNIFORM_BUFFER, CameraBuffer);
+        if (CameraBytes > GLsizeiptr(16 * sizeof(GLfloat)))
+        {
+            GLfloat both[2][16];
+            memcpy(both[0], eyeViewProj[0].constData(), sizeof(both[0]));
+            memcpy(both[1], eyeViewProj[1].constData(), sizeof(both[1]));
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(both), both);
+        }
+        else
+        {
+            for (int eye = 0; eye < 2; ++eye)
+                glBufferSubData(GL_UNIFORM_BUFFER, eye * CameraStride, CameraBytes, eyeViewProj[eye].constData());
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    // Where this frame's count world matrices go, null without an object
+    // buffer. Only blocks when the GPU is RegionCount - 1 frames behind.
+    GLfloat * MapObjects(int count)
+    {
+        if (!UseObjectBuffer)
+            return nullptr;
+
+        // Everything that reads the last frame's region was submitted by now.
+        if (ObjectBuffer)
+        {
+            Fences[Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            Region = (Region + 1) % RegionCount;
+        }
+
+        if (count > ObjectCapacity)
+            AllocateObjects(qMax(count, qMax(1024, 2 * ObjectCapacity)));
+
+        if (Fences[Region])
+        {
+            glClientWaitSync(Fences[Region], GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+            glDeleteSync(Fences[Region]);
+            Fences[Region] = 0;
+        }
+
+        return reinterpret_cast<GLfloat *>(ObjectMapping + Region * RegionStride);
+    }
+
+    void AllocateObjects(int capacity)
+    {
+        ReleaseObjects();
+
+        GLint alignment = 0;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        ObjectCapacity = capacity;
+        RegionStride = Align(capacity * 16 * sizeof(GLfloat), alignment);
+        Region = 0;
+
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glGenBuffers(1, &ObjectBuffer);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ObjectBuffer);
+        BufferStorage(GL_SHADER_STORAGE_BUFFER, RegionCount * RegionStride, nullptr, flags);
+        ObjectMapping = static_cast<char *>(glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, RegionCount * RegionStride, flags));
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        VALIDATE(ObjectMapping, "Failed to map the object buffer.");
+    }
+
+    // Binds what the draws of one camera block read.
+    void Bind(int cameraBlock, GLStateCache &state)
+    {
+        state.BindBufferRange(GL_UNIFORM_BUFFER, ShaderProgram::CameraBinding, CameraBuffer, cameraBlock * CameraStride, CameraBytes);
+        if (ObjectBuffer)
+            state.BindBufferRange(GL_SHADER_STORAGE_BUFFER, ShaderProgram::ObjectBinding, ObjectBuffer, Region * RegionStride, RegionStride);
+    }
+
+    void ReleaseObjects()
+    {
+        for (GLsync &fence : Fences)
+        {
+            if (fence)
+                glDeleteSync(fence);
+            fence = 0;
+        }
+
+        if (ObjectBuffer)
+        {
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, ObjectBuffer);
+            glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            glDeleteBuffers(1, &ObjectBuffer);
+            ObjectBuffer = 0;
+        }
+        ObjectMapping = nullptr;
+        ObjectCapacity = 0;
+    }
+
+    void Release()
+    {
+        ReleaseObjects();
+        if (CameraBuffer)
+        {
+            glDeleteBuffers(1, &CameraBuffer);
+            CameraBuffer = 0;
+        }
+        UseObjectBuffer = false;
+    }
+};
+
+// Compiles and links each distinct set of shader sources once, materials
+// built from the same sources share the program.
+struct ShaderRegistry : protected QOpenGLExtraFunctions
+{
+    QHash<QByteArray, ShaderProgram *> Programs;
+
+    ShaderRegistry()
+    {
+        initializeOpenGLFunctions();
+    }
+
+    ~ShaderRegistry()
+    {
+        Release();
+    }
+
+    void Release()
+    {
+        qDeleteAll(Programs);
+        Programs.clear();
+    }
+
+    GLuint CreateShader(GLenum type, const GLchar* header, const GLchar* src)
+    {
+        GLuint shader = glCreateShader(type);
+
+        const GLchar* sources[] = { header, src };
+        glShaderSource(shader, 2, sources, NULL);
+        glCompileShader(shader);
+
+        GLint r;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &r);
+        if (!r)
+        {
+            GLchar msg[1024];
+            glGetShaderInfoLog(shader, sizeof(msg), 0, msg);
+            if (msg[0]) {
+                qDebug("Compiling shader failed: %s\n", msg);
+            }
+            glDeleteShader(shader);
+            return 0;
+        }
+
+        return shader;
+    }
+
+    // Returns nullptr when either shader fails to compile or the program
+    // fails to link.
+    ShaderProgram * Get(const GLchar* vertexHeader, const GLchar* vertexSrc,
+                        const GLchar* fragmentHeader, const GLchar* fragmentSrc)
+    {
+        const QByteArray key = QByteArray(vertexHeader) + vertexSrc + '\0' + fragmentHeader + fragmentSrc;
+        ShaderProgram * program = Programs.value(key);
+        if (program)
+            return program;
+
+        GLuint vshader = CreateShader(GL_VERTEX_SHADER, vertexHeader, vertexSrc);
+        GLuint fshader = CreateShader(GL_FRAGMENT_SHADER, fragmentHeader, fragmentSrc);
+        if (vshader && fshader)
+        {
+            program = new ShaderProgram(vshader, fshader);
+            if (program->linked)
+            {
+                Programs.insert(key, program);
+            }
+            else
+            {
+                delete program;
+                program = nullptr;
+            }
+        }
+
+        glDeleteShader(vshader);
+        glDeleteShader(fshader);
+        return program;
+    }
+};
+
+// Program and texture are owned by the Scene, fills of the plain and the
+// instanced program share the same textures.
+struct ShaderFill
+{
+    ShaderProgram   * program;
+    TextureBuffer   * texture;
+
+    ShaderFill(ShaderProgram* _program, TextureBuffer* _texture) :
+        program(_program),
+        texture(_texture)
+    {
+    }
+};
+
+//----------------------------------------------------------------
+struct VertexBuffer : protected QOpenGLExtraFunctions
+{
+    GLuint    buffer;
+
+    VertexBuffer(const void* vertices, size_t size)
+    {
+        initializeOpenGLFunctions();
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+    }
+    ~VertexBuffer()
+    {
+        if (buffer)
+        {
+            glDeleteBuffers(1, &buffer);
+            buffer = 0;
+        }
+    }
+};
+
+//----------------------------------------------------------------
+struct IndexBuffer: protected QOpenGLExtraFunctions
+{
+    GLuint    buffer;
+
+    IndexBuffer(const void* indices, size_t size)
+    {
+        initializeOpenGLFunctions();
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, GL_STATIC_DRAW);
+    }
+    ~IndexBuffer()
+    {
+        if (buffer)
+        {
+            glDeleteBuffers(1, &buffer);
+            buffer = 0;
+        }
+    }
+};
+
+// Recycles the CPU side storage models build their geometry in. Geometry
+// only lives on the CPU until it is uploaded, so the few allocations made
+// by the first models get reused by every model built after them. Only a
+// few modest buffers are kept; the one a huge model or batch grew is freed
+// on release, so memory drops once that geometry is uploaded.
+template <typename T>
+struct StoragePool
+{
+    enum { MaxFree = 4, MaxBytes = 1 << 20 };
+
+    std::vector<std::vector<T>> Free;
+
+    std::vector<T> Acquire()
+    {
+        if (Free.empty())
+            return std::vector<T>();
+
+        std::vector<T> storage = std::move(Free.back());
+        Free.pop_back();
+        return storage;
+    }
+
+    void Release(std::vector<T> &storage)
+    {
+        if (storage.capacity() && storage.capacity() * sizeof(T) <= MaxBytes && Free.size() < MaxFree)
+        {
+            storage.clear();
+            Free.push_back(std::move(storage));
+        }
+        storage = std::vector<T>();
+    }
+};
+
+struct Model: protected QOpenGLExtraFunctions
+{
+    struct Vertex
+    {
+        QVector3D Pos;
+        quint32   C;
+        float     U, V;
+    };
+    static_assert(sizeof(Vertex) == sizeof(VRMeshFileVertex), "Mesh files are uploaded as Vertex arrays");
+
+    struct Pool
+    {
+        StoragePool<Vertex>   Vertices;
+        StoragePool<GLuint>   Indices;
+        StoragePool<GLushort> ShortIndices;
+    };
+
+    int             numVertices, numIndices;
+    GLenum          indexType;
+    size_t          indexOffset;    // bytes into indexBuffer, or into a glTF buffer view
+    Pool          * pool;
+    std::vector<Vertex> Vertices;   // CPU copy, released by AllocateBuffers
+    std::vector<GLuint> Indices;
+    ShaderFill    * Fill;
+    VertexBuffer  * vertexBuffer;
+    IndexBuffer   * indexBuffer;
+    GLuint          vertexArray;
+    bool            Static;         // drawn as part of its material's batch
+    bool            Dynamic;        // moves often, culled without the BVH
+    VRBounds        Bounds;         // model space
+
+    // Instanced models draw the geometry of Mesh once per instance rather
+    // than owning any, see AllocateInstances.
+    struct BoxInstance
+    {
+        QVector3D Offset;
+        QVector3D Size;
+        quint32   C;
+    };
+
+    const Model   * Mesh;
+    VertexBuffer  * instanceBuffer;
+    int             numInstances;
+
+    Model(ShaderFill * fill, Pool * _pool) :
+        numVertices(0),
+        numIndices(0),
+        indexType(GL_UNSIGNED_SHORT),
+        indexOffset(0),
+        pool(_pool),
+        Fill(fill),
+        vertexBuffer(nullptr),
+        indexBuffer(nullptr),
+        vertexArray(0),
+        Static(false),
+        Dynamic(false),
+        Mesh(nullptr),
+        instanceBuffer(nullptr),
+        numInstances(0)
+    {
+        initializeOpenGLFunctions();
+    }
+
+    ~Model()
+    {
+        FreeBuffers();
+        ReleaseGeometry();
+    }
+
+    // Storage is only taken from the pool once geometry is built, models
+    // drawing mesh files, glTF buffers or instances never hold any.
+    void AddVertex(const Vertex& v)
+    {
+        if (!Vertices.capacity())
+            Vertices = pool->Vertices.Acquire();
+        Vertices.push_back(v);
+        numVertices++;
+    }
+
+    void AddIndex(GLuint a)
+    {
+        if (!Indices.capacity())
+            Indices = pool->Indices.Acquire();
+        Indices.push_back(a);
+        numIndices++;
+    }
+
+    void ComputeBounds()
+    {
+        Bounds = VRBounds();
+        for (const Vertex &v : Vertices)
+            Bounds.expand(v.Pos);
+    }
+
+    // Appends the geometry of another model, moved into this model's space.
+    void AddModel(const Model &other, const QMatrix4x4 &transform)
+    {
+        const GLuint base = GLuint(numVertices);
+        for (const Vertex &v : other.Vertices)
+        {
+            Vertex vvv = v;
+            vvv.Pos = transform.map(v.Pos);
+            AddVertex(vvv);
+        }
+        for (GLuint index : other.Indices)
+            AddIndex(base + index);
+    }
+
+    void ReleaseGeometry()
+    {
+        pool->Vertices.Release(Vertices);
+        pool->Indices.Release(Indices);
+    }
+
+    // Uploads the geometry and records the vertex format in a vertex array
+    // object, so drawing only has to bind it. The CPU copy is released
+    // afterwards. Indices are uploaded as 16 bit whenever they fit.
+    void AllocateBuffers()
+    {
+        ComputeBounds();
+
+        vertexBuffer = new VertexBuffer(Vertices.data(), Vertices.size() * sizeof(Vertex));
+
+        if (numVertices <= 0x10000)
+        {
+            std::vector<GLushort> shortIndices = pool->ShortIndices.Acquire();
+            shortIndices.assign(Indices.begin(), Indices.end());
+            indexType = GL_UNSIGNED_SHORT;
+            indexBuffer = new IndexBuffer(shortIndices.data(), shortIndices.size() * sizeof(GLushort));
+            pool->ShortIndices.Release(shortIndices);
+        }
+        else
+        {
+            indexType = GL_UNSIGNED_INT;
+            indexBuffer = new IndexBuffer(Indices.data(), Indices.size() * sizeof(GLuint));
+        }
+
+        ReleaseGeometry();
+        CreateVertexArray();
+    }
+
+    // Uploads a mesh file straight from its mapping. Its blocks already have
+    // the layout of Vertex and of the index buffer, nothing is copied.
+    void AllocateBuffers(const VRMeshFile &mesh)
+    {
+        const VRMeshFileHeader &header = mesh.header();
+        Bounds = VRBounds();
+        Bounds.expand(QVector3D(header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2]));
+        Bounds.expand(QVector3D(header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2]));
+
+        numVertices = int(header.VertexCount);
+        numIndices = int(header.IndexCount);
+        vertexBuffer = new VertexBuffer(mesh.vertices(), size_t(mesh.vertexBytes()));
+        indexType = header.IndexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        indexBuffer = new IndexBuffer(mesh.indices(), size_t(mesh.indexBytes()));
+
+        CreateVertexArray();
+    }
+
+    // Draws a glTF primitive from the buffer views it is stored in, which
+    // belong to the import. Attributes the primitive doesn't have are read
+    // from the single vertex in vertexBuffer: with a divisor no instance
+    // count reaches, every vertex of every instance fetches that one.
+    void AllocateBuffers(const VRGltfImporter::Primitive &primitive, const QVector<VertexBuffer *> &views, quint32 color)
+    {
+        Bounds = primitive.Bounds;
+        numVertices = primitive.VertexCount;
+        numIndices = primitive.Indices.Count;
+        indexType = GLenum(primitive.Indices.ComponentType);    // glTF uses the GL enums
+        indexOffset = size_t(primitive.Indices.Offset);
+
+        const Vertex constant = { QVector3D(), color, 0.0f, 0.0f };
+        vertexBuffer = new VertexBuffer(&constant, sizeof(constant));
+
+        const ShaderProgram *program = Fill->program;
+
+        glGenVertexArrays(1, &vertexArray);
+        glBindVertexArray(vertexArray);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, views[primitive.Indices.View]->buffer);
+        SetStoredAttribute(program->posLoc, primitive.Position, views);
+        if (primitive.TexCoord.View >= 0)
+            SetStoredAttribute(program->uvLoc, primitive.TexCoord, views);
+        else
+            SetConstantAttribute(program->uvLoc, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, U));
+        SetConstantAttribute(program->colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(Vertex, C));
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    void SetStoredAttribute(GLint location, const VRGltfFile::Accessor &accessor, const QVector<VertexBuffer *> &views)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, views[accessor.View]->buffer);
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, accessor.Components, GLenum(accessor.ComponentType),
+                              accessor.Normalized ? GL_TRUE : GL_FALSE, accessor.Stride, (void*)size_t(accessor.Offset));
+    }
+
+    void SetConstantAttribute(GLint location, GLint size, GLenum type, GLboolean normalized, size_t offset)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->buffer);
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, size, type, normalized, sizeof(Vertex), (void*)offset);
+        glVertexAttribDivisor(location, ~0u);
+    }
+
+    void CreateVertexArray()
+    {
+        const ShaderProgram *program = Fill->program;
+
+        glGenVertexArrays(1, &vertexArray);
+        glBindVertexArray(vertexArray);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer->buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer->buffer);
+        SetVertexFormat(program);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    // Builds the vertex array for drawing mesh once per instance. Instance
+    // attributes advance once every viewCount instances, so in single pass
+    // stereo both eyes of a box read the same instance.
+    void AllocateInstances(const Model *mesh, const std::vector<BoxInstance> &instances, int viewCount)
+    {
+        Mesh = mesh;
+        numInstances = int(instances.size());
+
+        Bounds = VRBounds();
+        for (const BoxInstance &instance : instances)
+        {
+            Bounds.expand(instance.Offset);
+            Bounds.expand(instance.Offset + instance.Size);
+        }
+
+        instanceBuffer = new VertexBuffer((void*)instances.data(), instances.size() * sizeof(BoxInstance));
+
+        const ShaderProgram *program = Fill->program;
+
+        glGenVertexArrays(1, &vertexArray);
+        glBindVertexArray(vertexArray);
+
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->indexBuffer->buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh->vertexBuffer->buffer);
+        SetVertexFormat(program);
+
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer->buffer);
+
+        glEnableVertexAttribArray(program->instanceOffsetLoc);
+        glEnableVertexAttribArray(program->instanceSizeLoc);
+        glEnableVertexAttribArray(program->instanceColorLoc);
+
+        glVertexAttribPointer(program->instanceOffsetLoc, 3, GL_FLOAT, GL_FALSE, sizeof(BoxInstance), (void*)offsetof(BoxInstance, Offset));
+        glVertexAttribPointer(program->instanceSizeLoc, 3, GL_FLOAT, GL_FALSE, sizeof(BoxInstance), (void*)offsetof(BoxInstance, Size));
+        glVertexAttribPointer(program->instanceColorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(BoxInstance), (void*)offsetof(BoxInstance, C));
+
+        glVertexAttribDivisor(program->instanceOffsetLoc, viewCount);
+        glVertexAttribDivisor(program->instanceSizeLoc, viewCount);
+        glVertexAttribDivisor(program->instanceColorLoc, viewCount);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    // Vertex attributes of the buffer bound to GL_ARRAY_BUFFER.
+    void SetVertexFormat(const ShaderProgram *program)
+    {
+        glEnableVertexAttribArray(program->posLoc);
+        glEnableVertexAttribArray(program->colorLoc);
+        glEnableVertexAttribArray(program->uvLoc);
+
+        glVertexAttribPointer(program->posLoc, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Pos));
+        glVertexAttribPointer(program->colorLoc, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (void*)offsetof(Vertex, C));
+        glVertexAttribPointer(program->uvLoc, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, U));
+    }
+
+    void FreeBuffers()
+    {
+        if (vertexArray)
+        {
+            glDeleteVertexArrays(1, &vertexArray);
+            vertexArray = 0;
+        }
+        delete vertexBuffer; vertexBuffer = nullptr;
+        delete indexBuffer; indexBuffer = nullptr;
+        delete instanceBuffer; instanceBuffer = nullptr;
+    }
+
+    void AddSolidColorBox(float x1, float y1, float z1, float x2, float y2, float z2, quint32 c)
+    {
+        struct { QVector3D Pos; QVector2D UV; } Vert[] =
+            {
+                QVector3D(x1, y2, z1), QVector2D(z1, x1), QVector3D(x2, y2, z1), QVector2D(z1, x2),
+                QVector3D(x2, y2, z2), QVector2D(z2, x2), QVector3D(x1, y2, z2), QVector2D(z2, x1),
+                QVector3D(x1, y1, z1), QVector2D(z1, x1), QVector3D(x2, y1, z1), QVector2D(z1, x2),
+                QVector3D(x2, y1, z2), QVector2D(z2, x2), QVector3D(x1, y1, z2), QVector2D(z2, x1),
+                QVector3D(x1, y1, z2), QVector2D(z2, y1), QVector3D(x1, y1, z1), QVector2D(z1, y1),
+                QVector3D(x1, y2, z1), QVector2D(z1, y2), QVector3D(x1, y2, z2), QVector2D(z2, y2),
+                QVector3D(x2, y1, z2), QVector2D(z2, y1), QVector3D(x2, y1, z1), QVector2D(z1, y1),
+                QVector3D(x2, y2, z1), QVector2D(z1, y2), QVector3D(x2, y2, z2), QVector2D(z2, y2),
+                QVector3D(x1, y1, z1), QVector2D(x1, y1), QVector3D(x2, y1, z1), QVector2D(x2, y1),
+                QVector3D(x2, y2, z1), QVector2D(x2, y2), QVector3D(x1, y2, z1), QVector2D(x1, y2),
+                QVector3D(x1, y1, z2), QVector2D(x1, y1), QVector3D(x2, y1, z2), QVector2D(x2, y1),
+                QVector3D(x2, y2, z2), QVector2D(x2, y2), QVector3D(x1, y2, z2), QVector2D(x1, y2)
+            };
+
+        GLuint CubeIndices[] =
+            {
+                0, 1, 3, 3, 1, 2,
+                5, 4, 6, 6, 4, 7,
+                8, 9, 11, 11, 9, 10,
+                13, 12, 14, 14, 12, 15,
+                16, 17, 19, 19, 17, 18,
+                21, 20, 22, 22, 20, 23
+            };
+
+        for (int i = 0; i < sizeof(CubeIndices) / sizeof(CubeIndices[0]); ++i)
+            AddIndex(CubeIndices[i] + GLuint(numVertices));
+
+        // Generate a quad for each box face
+        for (int v = 0; v < 6 * 4; v++)
+        {
+            // Make vertices, with some token lighting
+            Vertex vvv; vvv.Pos = Vert[v].Pos; vvv.U = Vert[v].UV.x(); vvv.V = Vert[v].UV.y();
+            float dist1 = (vvv.Pos - QVector3D(-2, 4, -2)).length();
+            float dist2 = (vvv.Pos - QVector3D(3, 4, -3)).length();
+            float dist3 = (vvv.Pos - QVector3D(-4, 3, 25)).length();
+            int   bri = rand() % 160;
+            float B = ((c >> 16) & 0xff) * (bri + 192.0f * (0.65f + 8 / dist1 + 1 / dist2 + 4 / dist3)) / 255.0f;
+            float G = ((c >>  8) & 0xff) * (bri + 192.0f * (0.65f + 8 / dist1 + 1 / dist2 + 4 / dist3)) / 255.0f;
+            float R = ((c >>  0) & 0xff) * (bri + 192.0f * (0.65f + 8 / dist1 + 1 / dist2 + 4 / dist3)) / 255.0f;
+            vvv.C = (c & 0xff000000) +
+                    ((R > 255 ? 255 : quint32(R)) << 16) +
+                    ((G > 255 ? 255 : quint32(G)) << 8) +
+                    (B > 255 ? 255 : quint32(B));
+            AddVertex(vvv);
+        }
+    }
+
+    // Unit cube for instanced boxes. Only the random brightness of
+    // AddSolidColorBox is kept in the vertex color, and the texture
+    // coordinates name the axes each face is textured along; the instanced
+    // vertex shader does the rest per box.
+    void AddUnitCube()
+    {
+        static const float FaceAxes[3][2] = { { 2, 0 }, { 2, 1 }, { 0, 1 } };
+
+        const int first = numVertices;
+        AddSolidColorBox(0, 0, 0, 1, 1, 1, 0xffffffff);
+        for (int v = 0; v < 6 * 4; v++)
+        {
+            Vertex &vvv = Vertices[first + v];
+            quint32 bri = quint32(rand() % 160);
+            vvv.C = 0xff000000 | (bri << 16) | (bri << 8) | bri;
+            vvv.U = FaceAxes[v / 8][0];
+            vvv.V = FaceAxes[v / 8][1];
+        }
+    }
+
+    // Draws the model once per view. With two views both eyes are drawn by a
+    // single instanced draw call, see Scene::Init for the shader side.
+    // drawId indexes this frame's object buffer, which already holds world.
+    // Without one, world is uploaded here.
+    void Render(int drawId, int viewCount, const QMatrix4x4 &world, GLStateCache &state)
+    {
+        state.UseProgram(Fill->program->program);
+        state.BindTexture(Fill->texture->texId);
+        state.BindVertexArray(vertexArray);
+
+        if (Fill->program->drawIdLoc >= 0)
+            state.Uniform(Fill->program->drawIdLoc, drawId);
+        else
+            state.Uniform(Fill->program->worldLoc, world);
+
+        const Model &geometry = Mesh ? *Mesh : *this;
+        const int instanceCount = (Mesh ? numInstances : 1) * viewCount;
+        state.DrawElements(geometry.numIndices, geometry.indexType, GLintptr(geometry.indexOffset), instanceCount);
+    }
+};
+
+// Identifies a model in its Scene. Stays valid while other models are
+// added or removed, and stops resolving once its own model is removed.
+struct ModelHandle
+{
+    quint32 Index;
+    quint32 Generation;
+
+    ModelHandle() : Index(~0u), Generation(0) {}
+    ModelHandle(quint32 index, quint32 generation) : Index(index), Generation(generation) {}
+};
+
+struct Scene: protected QOpenGLExtraFunctions
+{
+    // Models and their world transforms are kept densely packed and in the
+    // same order, so rendering walks both arrays front to back. Removing a
+    // model moves the last one into its place; handles go through Slots to
+    // find where a model currently lives.
+    std::vector<Model *>    Models;
+    std::vector<QMatrix4x4> Transforms;
+    std::vector<VRBounds>   WorldBounds;
+    std::vector<quint32>    SlotOfModel;
+
+    struct Slot
+    {
+        quint32 Dense;      // index into Models, ~0u when free
+        quint32 Generation;
+    };
+    std::vector<Slot>       Slots;
+    std::vector<quint32>    FreeSlots;
+
+    int     ViewCount;  // 2 when both eyes are drawn in a single pass
+    ShaderRegistry Shaders;
+    FrameBuffers   Frame;
+    Model::Pool    Geometry;
+    TextureBuffer * Textures[VRMaterial::PatternCount];
+    ShaderFill   * Materials[VRMaterial::PatternCount];
+    ShaderFill   * InstancedMaterials[VRMaterial::PatternCount];  // null if the shader failed
+    Model        * UnitCube;
+    QHash<quint64, ModelHandle> ModelIds;   // VRModelData::Id to model
+
+    // World transforms of the VRModels, which may be nested. Models pick
+    // up the changes of a frame in UpdateTransforms(), only those that moved.
+    VRTransformHierarchy Hierarchy;
+    QVector<quint64>     MovedIds;
+    QVector<QMatrix4x4>  NodeWorlds;
+
+    // Textures are streamed in by the loader. Until they arrive materials
+    // sample a white placeholder.
+    VRTextureLoader * Loader;
+    ShaderProgram   * Program;
+    ShaderProgram   * InstancedProgram;     // null if the shader failed
+    QHash<int, TextureBuffer *>     PendingTextures;    // by loader request
+    QHash<QString, TextureBuffer *> SourceTextures;     // VRModelData::Texture
+    QHash<QString, ShaderFill *>    SourceMaterials;
+    QHash<QString, ShaderFill *>    InstancedSourceMaterials;
+
+    // glTF sources are imported on worker threads, see UpdateImports().
+    // Each primitive becomes a model placed at the VRModel's world
+    // transform times its node's. The buffer views, textures and materials the
+    // models use belong to the import and go with it.
+    struct Import
+    {
+        int                      Request = 0;
+        bool                     Dynamic = false;
+        QVector<ModelHandle>     Handles;
+        QVector<QMatrix4x4>      NodeTransforms;    // parallel to Handles
+        QVector<VertexBuffer *>  Views;
+        QVector<TextureBuffer *> Textures;
+        QVector<ShaderFill *>    Fills;
+    };
+    VRGltfImporter          Importer;
+    QHash<quint64, Import>  Imports;            // by VRModelData::Id
+    QHash<int, quint64>     ImportRequests;
+
+    // Static models keep their geometry on the CPU and are drawn merged
+    // with the other static models of the same material whose centers fall
+    // in the same BatchCellSize cell, one draw call per material and cell.
+    // Cells keep batches small enough to be culled. A material's batches
+    // are rebuilt before the next frame whenever one of its models is added,
+    // removed or moved.
+    static constexpr float BatchCellSize = 10.0f;
+    QHash<ShaderFill *, std::vector<Model *>> Batches;
+    QSet<ShaderFill *>           DirtyBatches;
+
+    // Everything that is neither batched nor dynamic is culled through the
+    // BVH, which is rebuilt when any of it changes. Dynamic models are
+    // tested one by one.
+    struct Drawable
+    {
+        Model * M;
+        int     Dense;      // index into Models, -1 for batches
+    };
+    std::vector<Drawable> BvhItems;
+    VRBvh                 Bvh;
+    bool                  BvhDirty;
+
+    std::vector<Drawable> Visible;      // filled by Cull()
+    QVector<int>          VisibleItems;
+
+    int     ModelCount() const { return int(Models.size()); }
+
+    // Takes ownership of the model.
+    ModelHandle Add(Model * n, const QMatrix4x4 &transform = QMatrix4x4())
+    {
+        quint32 slot;
+        if (!FreeSlots.empty())
+        {
+            slot = FreeSlots.back();
+            FreeSlots.pop_back();
+        }
+        else
+        {
+            slot = quint32(Slots.size());
+            Slots.push_back({ ~0u, 0 });
+        }
+
+        Slots[slot].Dense = quint32(Models.size());
+        if (n->Static)
+            DirtyBatches.insert(n->Fill);
+        else if (!n->Dynamic)
+            BvhDirty = true;
+        Models.push_back(n);
+        Transforms.push_back(transform);
+        WorldBounds.push_back(n->Bounds.transformed(transform));
+        SlotOfModel.push_back(slot);
+
+        return ModelHandle(slot, Slots[slot].Generation);
+    }
+
+    // Deletes the model. Returns false if the handle was already stale.
+    bool Remove(ModelHandle handle)
+    {
+        const int dense = Find(handle);
+        if (dense < 0)
+            return false;
+
+        if (Models[dense]->Static)
+            DirtyBatches.insert(Models[dense]->Fill);
+        delete Models[dense];
+
+        const int last = int(Models.size()) - 1;
+        if (dense != last)
+        {
+            Models[dense] = Models[last];
+            Transforms[dense] = Transforms[last];
+            WorldBounds[dense] = WorldBounds[last];
+            SlotOfModel[dense] = SlotOfModel[last];
+            Slots[SlotOfModel[dense]].Dense = quint32(dense);
+        }
+        Models.pop_back();
+        Transforms.pop_back();
+        WorldBounds.pop_back();
+        SlotOfModel.pop_back();
+
+        // BVH items refer to dense indices, which just moved.
+        BvhDirty = true;
+
+        Slots[handle.Index].Dense = ~0u;
+        Slots[handle.Index].Generation++;
+        FreeSlots.push_back(handle.Index);
+        return true;
+    }
+
+    // Dense index of the model, -1 for stale handles.
+    int Find(ModelHandle handle) const
+    {
+        if (handle.Index >= Slots.size())
+            return -1;
+        const Slot &slot = Slots[handle.Index];
+        if (slot.Generation != handle.Generation || slot.Dense == ~0u)
+            return -1;
+        return int(slot.Dense);
+    }
+
+    Model * Get(ModelHandle handle) const
+    {
+        const int dense = Find(handle);
+        return dense < 0 ? nullptr : Models[dense];
+    }
+
+    void SetTransform(ModelHandle handle, const QMatrix4x4 &transform)
+    {
+        const int dense = Find(handle);
+        if (dense >= 0)
+        {
+            Model * m = Models[dense];
+            Transforms[dense] = transform;
+            WorldBounds[dense] = m->Bounds.transformed(transform);
+            if (m->Static)
+                DirtyBatches.insert(m->Fill);
+            else if (!m->Dynamic)
+                BvhDirty = true;
+        }
+    }
+
+    void UpdateBatches()
+    {
+        for (ShaderFill * fill : qAsConst(DirtyBatches))
+        {
+            for (Model * batch : Batches.value(fill))
+                delete batch;
+            Batches.remove(fill);
+
+            std::map<std::tuple<int, int, int>, Model *> cells;
+            const int count = ModelCount();
+            for (int i = 0; i < count; ++i)
+            {
+                if (!Models[i]->Static || Models[i]->Fill != fill)
+                    continue;
+
+                const QVector3D center = WorldBounds[i].center() / BatchCellSize;
+                Model *& batch = cells[std::make_tuple(qFloor(center.x()), qFloor(center.y()), qFloor(center.z()))];
+                if (!batch)
+                    batch = new Model(fill, &Geometry);
+                batch->AddModel(*Models[i], Transforms[i]);
+            }
+
+            std::vector<Model *> &batches = Batches[fill];
+            for (const auto &cell : cells)
+            {
+                cell.second->AllocateBuffers();
+                batches.push_back(cell.second);
+            }
+        }
+        DirtyBatches.clear();
+        BvhDirty = true;
+    }
+
+    void UpdateBvh()
+    {
+        BvhItems.clear();
+        QVector<VRBounds> bounds;
+
+        for (const std::vector<Model *> &batches : qAsConst(Batches))
+        {
+            for (Model * batch : batches)
+            {
+                BvhItems.push_back({ batch, -1 });
+                bounds.append(batch->Bounds);
+            }
+        }
+
+        const int count = ModelCount();
+        for (int i = 0; i < count; ++i)
+        {
+            if (!Models[i]->Static && !Models[i]->Dynamic)
+            {
+                BvhItems.push_back({ Models[i], i });
+                bounds.append(WorldBounds[i]);
+            }
+        }
+
+        Bvh.build(bounds);
+        BvhDirty = false;
+    }
+
+    // Picks what Render() draws this frame: whatever is inside either eye's
+    // frustum, so both eyes (one pass or two) share a single traversal.
+    void Cull(const QMatrix4x4 eyeViewProj[2], bool enabled, VRFrameStatistics::DrawCounters &counters)
+    {
+        if (!DirtyBatches.isEmpty())
+            UpdateBatches();
+        if (BvhDirty)
+            UpdateBvh();
+
+        Visible.clear();
+        const int count = ModelCount();
+
+        if (!enabled)
+        {
+            Visible = BvhItems;
+            for (int i = 0; i < count; ++i)
+            {
+                if (Models[i]->Dynamic)
+                    Visible.push_back({ Models[i], i });
+            }
+            return;
+        }
+
+        const VRFrustum frusta[2] = { VRFrustum(eyeViewProj[0]), VRFrustum(eyeViewProj[1]) };
+
+        VisibleItems.clear();
+        Bvh.query(frusta, 2, VisibleItems);
+        for (int item : qAsConst(VisibleItems))
+            Visible.push_back(BvhItems[item]);
+
+        int dynamicCount = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            if (!Models[i]->Dynamic)
+                continue;
+
+            ++dynamicCount;
+            if (frusta[0].intersects(WorldBounds[i]) || frusta[1].intersects(WorldBounds[i]))
+                Visible.push_back({ Models[i], i });
+        }
+
+        counters.Culled += int(BvhItems.size()) + dynamicCount - int(Visible.size());
+    }
+
+    // Writes the world matrices of what the last Cull() found visible.
+    void PrepareFrame()
+    {
+        if (GLfloat * objects = Frame.MapObjects(int(Visible.size())))
+        {
+            const QMatrix4x4 identity;
+            for (const Drawable &drawable : Visible)
+            {
+                const QMatrix4x4 &world = drawable.Dense < 0 ? identity : Transforms[drawable.Dense];
+                memcpy(objects, world.constData(), 16 * sizeof(GLfloat));
+                objects += 16;
+            }
+        }
+    }
+
+    // Called after PrepareFrame(), as late as possible: every draw reads
+    // these matrices, nothing on the CPU depends on them.
+    void SetCamera(const QMatrix4x4 eyeViewProj[2])
+    {
+        Frame.SetCamera(eyeViewProj);
+    }
+
+    // Draws what the last Cull() found visible, with the camera of eye, or
+    // of both eyes in single pass mode. There the render target holds both
+    // eyes side by side and GL_CLIP_DISTANCE0 keeps each eye inside its
+    // own half.
+    void Render(int eye, VRFrameStatistics::DrawCounters &counters)
+    {
+        GLStateCache state(counters);
+        state.Reset();
+        if (ViewCount > 1)
+            state.Enable(GL_CLIP_DISTANCE0);
+        state.Enable(GL_DEPTH_TEST);
+        state.DepthFunc(GL_LESS);
+        Frame.Bind(ViewCount > 1 ? 0 : eye, state);
+
+        const QMatrix4x4 identity;
+        for (int i = 0; i < int(Visible.size()); ++i)
+        {
+            const Drawable &drawable = Visible[i];
+            drawable.M->Render(i, ViewCount, drawable.Dense < 0 ? identity : Transforms[drawable.Dense], state);
+        }
+
+        // Leave nothing bound that later buffer or texture updates could
+        // accidentally modify.
+        state.BindVertexArray(0);
+        state.UseProgram(0);
+
+        state.Disable(GL_DEPTH_TEST);
+        if (ViewCount > 1)
+            state.Disable(GL_CLIP_DISTANCE0);
+    }
+
+    void Init(bool singlePassStereo, VRTextureLoader * loader)
+    {
+        Loader = loader;
+
+        // OBJECT_BUFFER programs take world matrices from the storage buffer
+        // of FrameBuffers, which needs GLSL 4.30.
+        bool objectBuffer = Frame.SupportsObjectBuffer();
+        const auto header = [&objectBuffer](int viewCount, bool instanced) -> QByteArray {
+            QByteArray text = objectBuffer ? "#version 430\n#define OBJECT_BUFFER 1\n" : "#version 150\n";
+            text += "#define VIEW_COUNT " + QByteArray::number(viewCount) + "\n";
+            if (instanced)
+                text += "#define INSTANCED 1\n";
+            return text;
+        };
+
+        // With VIEW_COUNT 2, instance N draws eye N. Each eye is squeezed into
+        // its half of the shared render target: x' = (x + side * w) / 2, and
+        // clipped where it would spill over into the other eye's half.
+        //
+        // With INSTANCED the unit cube is scaled and moved to the box of the
+        // instance, and the token lighting and texture coordinates that
+        // Model::AddSolidColorBox bakes into vertices are computed here.
+        static const GLchar* VertexShaderSrc =
+            "layout(std140) uniform Camera { mat4 ViewProj[VIEW_COUNT]; };\n"
+            "#ifdef OBJECT_BUFFER\n"
+            "layout(std430, binding = 1) readonly buffer Objects { mat4 ObjectWorld[]; };\n"
+            "uniform int  DrawId;\n"
+            "#define WORLD ObjectWorld[DrawId]\n"
+            "#else\n"
+            "uniform mat4 World;\n"
+            "#define WORLD World\n"
+            "#endif\n"
+            "in      vec4 Position;\n"
+            "in      vec4 Color;\n"
+            "in      vec2 TexCoord;\n"
+            "#ifdef INSTANCED\n"
+            "in      vec3 InstanceOffset;\n"
+            "in      vec3 InstanceSize;\n"
+            "in      vec4 InstanceColor;\n"
+            "#endif\n"
+            "out     vec2 oTexCoord;\n"
+            "out     vec4 oColor;\n"
+            "void main()\n"
+            "{\n"
+            "#ifdef INSTANCED\n"
+            "   vec3  local    = InstanceOffset + Position.xyz * InstanceSize;\n"
+            "   float light    = Color.r + 192.0 / 255.0 * (0.65 + 8.0 / distance(local, vec3(-2.0, 4.0, -2.0))\n"
+            "                                                 + 1.0 / distance(local, vec3( 3.0, 4.0, -3.0))\n"
+            "                                                 + 4.0 / distance(local, vec3(-4.0, 3.0, 25.0)));\n"
+            "   vec4  position = vec4(local, 1.0);\n"
+            "   vec4  color    = vec4(min(InstanceColor.rgb * light, vec3(1.0)), InstanceColor.a);\n"
+            "   vec2  texCoord = vec2(local[int(TexCoord.x)], local[int(TexCoord.y)]);\n"
+            "#else\n"
+            "   vec4  position = Position;\n"
+            "   vec4  color    = Color;\n"
+            "   vec2  texCoord = TexCoord;\n"
+            "#endif\n"
+            "#if VIEW_COUNT > 1\n"
+            "   int   eye  = gl_InstanceID % VIEW_COUNT;\n"
+            "   float side = float(eye) * 2.0 - 1.0;\n"
+            "   vec4  pos  = ViewProj[eye] * (WORLD * position);\n"
+            "   gl_ClipDistance[0] = pos.w + side * pos.x;\n"
+            "   gl_Position = vec4(0.5 * (pos.x + side * pos.w), pos.yzw);\n"
+            "#else\n"
+            "   gl_Position = ViewProj[0] * (WORLD * position);\n"
+            "#endif\n"
+            "   oTexCoord   = texCoord;\n"
+            "   oColor.rgb  = pow(color.rgb, vec3(2.2));\n"   // convert from sRGB to linear
+            "   oColor.a    = color.a;\n"
+            "}\n";
+
+        static const char* FragmentShaderSrc =
+            "uniform sampler2D Texture0;\n"
+            "in      vec4      oColor;\n"
+            "in      vec2      oTexCoord;\n"
+            "out     vec4      FragColor;\n"
+            "void main()\n"
+            "{\n"
+            "   FragColor = oColor * texture(Texture0, oTexCoord);\n"
+            "}\n";
+
+        const auto build = [&](bool instanced) {
+            return Shaders.Get(header(ViewCount, instanced).constData(), VertexShaderSrc, header(1, false).constData(), FragmentShaderSrc);
+        };
+
+        ViewCount = singlePassStereo ? 2 : 1;
+        ShaderProgram * program = build(false);
+        if (!program && objectBuffer)
+        {
+            qWarning("Object buffer shader failed to build, falling back to per draw world matrices.");
+            objectBuffer = false;
+            program = build(false);
+        }
+        if (!program && singlePassStereo)
+        {
+            qWarning("Single pass stereo shader failed to build, falling back to one pass per eye.");
+            ViewCount = 1;
+            program = build(false);
+        }
+        VALIDATE(program, "Failed to build the scene shaders.");
+
+        ShaderProgram * instancedProgram = build(true);
+        if (!instancedProgram)
+        {
+            qWarning("Instanced box shader failed to build, instanced models are drawn as plain geometry.");
+        }
+
+        Frame.Init(ViewCount, objectBuffer);
+
+        Program = program;
+        InstancedProgram = instancedProgram;
+
+        // Make textures, one per VRMaterial::Pattern
+        for (int k = 0; k < VRMaterial::PatternCount; ++k)
+        {
+            Textures[k] = LoadTexture(Loader->load([k]() {
+                QImage image(256, 256, QImage::Format_RGBA8888);
+                for (int j = 0; j < 256; ++j)
+                {
+                    quint32 * tex_pixels = reinterpret_cast<quint32 *>(image.scanLine(j));
+                    for (int i = 0; i < 256; ++i)
+                    {
+                        if (k == 0) tex_pixels[i] = (((i >> 7) ^ (j >> 7)) & 1) ? 0xffb4b4b4 : 0xff505050;// floor
+                        if (k == 1) tex_pixels[i] = (((j / 4 & 15) == 0) || (((i / 4 & 15) == 0) && ((((i / 4 & 31) == 0) ^ ((j / 4 >> 4) & 1)) == 0)))
+                                                    ? 0xff3c3c3c : 0xffb4b4b4;// wall
+                        if (k == 2) tex_pixels[i] = (i / 4 == 0 || j / 4 == 0) ? 0xff505050 : 0xffb4b4b4;// ceiling
+                        if (k == 3) tex_pixels[i] = 0xffffffff;// blank
+                    }
+                }
+                return image;
+            }));
+            Materials[k] = new ShaderFill(program, Textures[k]);
+            if (instancedProgram)
+                InstancedMaterials[k] = new ShaderFill(instancedProgram, Textures[k]);
+        }
+
+        if (instancedProgram)
+        {
+            UnitCube = new Model(InstancedMaterials[VRMaterial::Blank], &Geometry);
+            UnitCube->AddUnitCube();
+            UnitCube->AllocateBuffers();
+        }
+    }
+
+    // Returns a placeholder that the loaded texture replaces once ready.
+    TextureBuffer * LoadTexture(int request)
+    {
+        static const quint32 white = 0xffffffff;
+        TextureBuffer * texture = new TextureBuffer(false, QSize(1, 1), 1, (unsigned char *)&white);
+        PendingTextures.insert(request, texture);
+        return texture;
+    }
+
+    // Swaps the textures the loader finished in for their placeholders.
+    // Drains the loader even with nothing pending, textures whose
+    // placeholder was released meanwhile are deleted rather than left queued.
+    void UpdateTextures()
+    {
+        QVector<VRTextureLoader::Texture> finished;
+        Loader->takeFinished(finished);
+        for (const VRTextureLoader::Texture &texture : qAsConst(finished))
+        {
+            TextureBuffer * target = PendingTextures.take(texture.Request);
+            if (target && texture.Id)
+                target->Replace(texture.Id, texture.Size);
+            else if (texture.Id)
+                glDeleteTextures(1, &texture.Id);
+        }
+    }
+
+    void ReleaseTexture(TextureBuffer * texture)
+    {
+        PendingTextures.remove(PendingTextures.key(texture));
+        delete texture;
+    }
+
+    // Creates the models of the imports that finished since the last frame.
+    // Drains the importer even with nothing requested, assets of imports
+    // removed or rebuilt meanwhile are dropped rather than left queued.
+    void UpdateImports()
+    {
+        QVector<VRGltfImporter::Asset> finished;
+        Importer.takeFinished(finished);
+        for (const VRGltfImporter::Asset &asset : qAsConst(finished))
+        {
+            // Removed or rebuilt while importing
+            if (!ImportRequests.contains(asset.Request))
+                continue;
+
+            const quint64 id = ImportRequests.take(asset.Request);
+            Import &import = Imports[id];
+            if (!asset.Error.isEmpty())
+            {
+                qWarning("Failed to load %s: %s", qPrintable(asset.FileName), qPrintable(asset.Error));
+                continue;
+            }
+            BuildImport(id, import, asset);
+        }
+    }
+
+    void BuildImport(quint64 id, Import &import, const VRGltfImporter::Asset &asset)
+    {
+        for (const QByteArray &view : asset.Views)
+            import.Views.append(view.isNull() ? nullptr : new VertexBuffer(view.constData(), size_t(view.size())));
+
+        // Not mirrored like other textures, glTF texture coordinates start
+        // at the top row.
+        for (const VRGltfImporter::Image &image : asset.Images)
+        {
+            import.Textures.append(LoadTexture(Loader->load([image]() {
+                QImage decoded = image.Data.isEmpty() ? QImage(image.FileName) : QImage::fromData(image.Data);
+                if (decoded.isNull())
+                    qWarning("Failed to decode a glTF image %s", qPrintable(image.FileName));
+                return decoded;
+            })));
+        }
+
+        for (const VRGltfImporter::Material &material : asset.Materials)
+        {
+            TextureBuffer * texture = material.Image >= 0 ? import.Textures[material.Image] : Textures[VRMaterial::Blank];
+            import.Fills.append(new ShaderFill(Program, texture));
+        }
+
+        for (const VRGltfImporter::Primitive &primitive : asset.Primitives)
+        {
+            const bool hasMaterial = primitive.Material >= 0 && primitive.Material < import.Fills.size();
+            Model * m = new Model(hasMaterial ? import.Fills[primitive.Material] : Materials[VRMaterial::Blank], &Geometry);
+            m->Dynamic = import.Dynamic;
+
+            if (primitive.isStored())
+            {
+                m->AllocateBuffers(primitive, import.Views, hasMaterial ? asset.Materials[primitive.Material].Color : 0xffffffff);
+            }
+            else
+            {
+                const Model::Vertex * vertices = reinterpret_cast<const Model::Vertex *>(primitive.Vertices.constData());
+                m->Vertices = Geometry.Vertices.Acquire();
+                m->Indices = Geometry.Indices.Acquire();
+                m->Vertices.assign(vertices, vertices + primitive.Vertices.size());
+                m->Indices.assign(primitive.ConvertedIndices.begin(), primitive.ConvertedIndices.end());
+                m->numVertices = primitive.Vertices.size();
+                m->numIndices = primitive.ConvertedIndices.size();
+                m->AllocateBuffers();
+            }
+
+            import.Handles.append(Add(m, VRSimd::multiply(Hierarchy.world(id), primitive.Transform)));
+            import.NodeTransforms.append(primitive.Transform);
+        }
+    }
+
+    void ReleaseImport(quint64 id)
+    {
+        auto it = Imports.find(id);
+        if (it == Imports.end())
+            return;
+
+        for (ModelHandle handle : qAsConst(it->Handles))
+            Remove(handle);
+        qDeleteAll(it->Fills);
+        qDeleteAll(it->Views);
+        for (TextureBuffer * texture : qAsConst(it->Textures))
+            ReleaseTexture(texture);
+        ImportRequests.remove(it->Request);
+        Imports.erase(it);
+    }
+
+    ShaderFill * MaterialFor(const VRModelData &data, bool instanced)
+    {
+        const int pattern = qBound(0, data.Pattern, VRMaterial::PatternCount - 1);
+        if (data.Texture.isEmpty())
+            return instanced ? InstancedMaterials[pattern] : Materials[pattern];
+
+        TextureBuffer *& texture = SourceTextures[data.Texture];
+        if (!texture)
+            texture = LoadTexture(Loader->load(data.Texture));
+
+        ShaderFill *& fill = instanced ? InstancedSourceMaterials[data.Texture] : SourceMaterials[data.Texture];
+        if (!fill)
+            fill = new ShaderFill(instanced ? InstancedProgram : Program, texture);
+        return fill;
+    }
+
+    // Creates, rebuilds or moves the models mirroring a VRModel.
+    void ApplyModel(const VRModelData &data)
+    {
+        if (data.Removed)
+        {
+            Remove(ModelIds.take(data.Id));
+            ReleaseImport(data.Id);
+            Hierarchy.remove(data.Id);
+            return;
+        }
+
+        // Moves are applied by UpdateTransforms(), once the whole batch of
+        // changes is in.
+        Hierarchy.set(data.Id, data.ParentId, data.Transform);
+        if (!data.GeometryChanged)
+            return;
+
+        ModelHandle handle = ModelIds.value(data.Id);
+        Remove(handle);
+        ModelIds.remove(data.Id);
+        ReleaseImport(data.Id);
+
+        if (data.Boxes.isEmpty() && data.Mesh.isEmpty())
+            return;
+
+        if (VRGltfImporter::isGltfFile(data.Mesh))
+        {
+            Import &created = Imports[data.Id];
+            created.Request = Importer.load(data.Mesh);
+            created.Dynamic = data.Dynamic;
+            ImportRequests.insert(created.Request, data.Id);
+            return;
+        }
+
+        Model * m;
+        if (!data.Mesh.isEmpty())
+        {
+            VRMeshFile mesh;
+            QString error;
+            if (!mesh.open(data.Mesh, &error))
+            {
+                qWarning("Failed to load mesh %s: %s", qPrintable(data.Mesh), qPrintable(error));
+                return;
+            }
+
+            // Already a single draw call, never batched.
+            m = new Model(MaterialFor(data, false), &Geometry);
+            m->Dynamic = data.Dynamic;
+            m->AllocateBuffers(mesh);
+        }
+        else if (data.Instanced && UnitCube)
+        {
+            std::vector<Model::BoxInstance> instances;
+            instances.reserve(data.Boxes.size());
+            for (const VRModelData::Box &box : data.Boxes)
+            {
+                // 0xAARRGGBB to the R, G, B, A byte order the attribute reads
+                const quint32 c = (box.Color & 0xff00ff00) | ((box.Color >> 16) & 0xff) | ((box.Color & 0xff) << 16);
+                instances.push_back({ box.From, box.To - box.From, c });
+            }
+
+            m = new Model(MaterialFor(data, true), &Geometry);
+            m->Dynamic = data.Dynamic;
+            m->AllocateInstances(UnitCube, instances, ViewCount);
+        }
+        else
+        {
+            m = new Model(MaterialFor(data, false), &Geometry);
+            for (const VRModelData::Box &box : data.Boxes)
+                m->AddSolidColorBox(box.From.x(), box.From.y(), box.From.z(), box.To.x(), box.To.y(), box.To.z(), box.Color);
+            m->Static = !data.Dynamic;
+            m->Dynamic = data.Dynamic;
+            if (m->Static)
+                m->ComputeBounds();
+            else
+                m->AllocateBuffers();
+        }
+        ModelIds.insert(data.Id, Add(m, Hierarchy.world(data.Id)));
+    }
+
+    // Moves the models of VRModels whose world transform changed, their
+    // own or one of their parents'.
+    void UpdateTransforms()
+    {
+        MovedIds.clear();
+        Hierarchy.update(MovedIds);
+        for (quint64 id : qAsConst(MovedIds))
+        {
+            const QMatrix4x4 world = Hierarchy.world(id);
+            const ModelHandle handle = ModelIds.value(id);
+            if (Find(handle) >= 0)
+                SetTransform(handle, world);
+
+            const auto import = Imports.constFind(id);
+            if (import != Imports.constEnd())
+            {
+                NodeWorlds.resize(import->Handles.size());
+                VRSimd::multiply(world, import->NodeTransforms.constData(), NodeWorlds.data(), NodeWorlds.size());
+                for (int i = 0; i < import->Handles.size(); ++i)
+                    SetTransform(import->Handles[i], NodeWorlds[i]);
+            }
+        }
+    }
+
+    Scene() : ViewCount(1), UnitCube(nullptr), Loader(nullptr), Program(nullptr), InstancedProgram(nullptr), BvhDirty(false) {
+        initializeOpenGLFunctions();
+        memset(Textures, 0, sizeof(Textures));
+        memset(Materials, 0, sizeof(Materials));
+        memset(InstancedMaterials, 0, sizeof(InstancedMaterials));
+    }
+
+    Scene(bool singlePassStereo, VRTextureLoader * loader) :
+        ViewCount(1),
+        UnitCube(nullptr),
+        Loader(nullptr),
+        Program(nullptr),
+        InstancedProgram(nullptr),
+        BvhDirty(false)
+    {
+        initializeOpenGLFunctions();
+        memset(Textures, 0, sizeof(Textures));
+        memset(Materials, 0, sizeof(Materials));
+        memset(InstancedMaterials, 0, sizeof(InstancedMaterials));
+        Init(singlePassStereo, loader);
+    }
+    void Release()
+    {
+        for (Model * model : Models)
+            delete model;
+        Models.clear();
+        Transforms.clear();
+        WorldBounds.clear();
+        SlotOfModel.clear();
+        Slots.clear();
+        FreeSlots.clear();
+        ModelIds.clear();
+        Hierarchy.clear();
+
+        for (Import &import : Imports)
+        {
+            qDeleteAll(import.Fills);
+            qDeleteAll(import.Views);
+            qDeleteAll(import.Textures);
+        }
+        Imports.clear();
+        ImportRequests.clear();
+
+        for (const std::vector<Model *> &batches : qAsConst(Batches))
+        {
+            for (Model * batch : batches)
+                delete batch;
+        }
+        Batches.clear();
+        DirtyBatches.clear();
+
+        BvhItems.clear();
+        Bvh.clear();
+        Visible.clear();
+        BvhDirty = false;
+
+        delete UnitCube;
+        UnitCube = nullptr;
+
+        for (int k = 0; k < VRMaterial::PatternCount; ++k)
+        {
+            delete Materials[k];
+            delete InstancedMaterials[k];
+            delete Textures[k];
+            Materials[k] = nullptr;
+            InstancedMaterials[k] = nullptr;
+            Textures[k] = nullptr;
+        }
+
+        qDeleteAll(SourceMaterials);
+        qDeleteAll(InstancedSourceMaterials);
+        qDeleteAll(SourceTextures);
+        SourceMaterials.clear();
+        InstancedSourceMaterials.clear();
+        SourceTextures.clear();
+        PendingTextures.clear();
+        Program = nullptr;
+        InstancedProgram = nullptr;
+        Frame.Release();
+    }
+    ~Scene()
+    {
+        Release();
+    }
+};
+
+// Fixed foveated rendering for the eye buffers. Before the scene is drawn,
+// Mask() writes the nearest depth into the pixels of the periphery that
+// won't be shaded, so the depth test rejects them before their fragment
+// shader runs; Fill() then copies the shaded pixels over the holes. Both
+// work in 2x2 pixel quads, the unit GPUs shade in, grouped into 4x4 pixel
+// blocks whose first quad is always shaded:
+//
+//   inside Radius                    every quad
+//   up to Radius + Falloff           2 of 4 quads, on the block's diagonal
+//   beyond                           the first quad, a quarter resolution
+//
+// Distances are measured from the center of each eye's projection, in
+// units of half the viewport height. Filled pixels get the far depth.
+struct Foveation : protected QOpenGLExtraFunctions
+{
+    // Uniform locations of the mask and the fill program.
+    struct Pattern
+    {
+        ShaderProgram * Program = nullptr;
+        GLint           EyeSizeLoc = -1;
+        GLint           CenterLoc = -1;
+        GLint           RadiusLoc = -1;
+        GLint           FalloffLoc = -1;
+    };
+
+    ShaderRegistry  Shaders;
+    Pattern         Mask;
+    Pattern         Fill;
+    GLuint          VertexArray = 0;
+    GLuint          CopyFbo = 0;
+    GLuint          CopyTexture = 0;
+    QSize           CopySize;
+
+    bool Init()
+    {
+        initializeOpenGLFunctions();
+
+        // A triangle covering the viewport, from gl_VertexID alone.
+        static const char * vertexSrc =
+            "#version 150\n"
+            "void main()\n"
+            "{\n"
+            "   vec2 corner = vec2((gl_VertexID & 1) * 4 - 1, (gl_VertexID & 2) * 2 - 1);\n"
+            "   gl_Position = vec4(corner, -1.0, 1.0);\n"
+            "}\n";
+
+        static const char * patternSrc =
+            "#version 150\n"
+            "uniform vec2  EyeSize;\n"
+            "uniform vec2  Center[2];\n"
+            "uniform float Radius;\n"
+            "uniform float Falloff;\n"
+            "out     vec4  FragColor;\n"
+            "ivec2 EyeOrigin(ivec2 pixel)\n"
+            "{\n"
+            "   return ivec2(pixel.x >= int(EyeSize.x) ? int(EyeSize.x) : 0, 0);\n"
+            "}\n"
+            "bool Shaded(ivec2 pixel)\n"
+            "{\n"
+            "   ivec2 origin = EyeOrigin(pixel);\n"
+            "   ivec2 local  = pixel - origin;\n"
+            "   vec2  block  = vec2(local / 4 * 4 + 2);\n"
+            "   vec2  offset = block / EyeSize * 2.0 - 1.0 - Center[origin.x > 0 ? 1 : 0];\n"
+            "   float d      = length(vec2(offset.x * EyeSize.x / EyeSize.y, offset.y));\n"
+            "   ivec2 quad   = local / 2 % 2;\n"
+            "   if (d < Radius)\n"
+            "       return true;\n"
+            "   if (d < Radius + Falloff)\n"
+            "       return quad.x == quad.y;\n"
+            "   return quad.x == 0 && quad.y == 0;\n"
+            "}\n"
+            "ivec2 Source(ivec2 pixel)\n"
+            "{\n"
+            "   ivec2 origin = EyeOrigin(pixel);\n"
+            "   ivec2 local  = pixel - origin;\n"
+            "   return origin + local / 4 * 4 + local % 2;\n"
+            "}\n";
+
+        static const char * maskSrc =
+            "void main()\n"
+            "{\n"
+            "   if (Shaded(ivec2(gl_FragCoord.xy)))\n"
+            "       discard;\n"
+            "   FragColor = vec4(0.0);\n"
+            "}\n";
+
+        // The copy is bound to unit 0, where ShaderProgram points Texture0.
+        static const char * fillSrc =
+            "uniform sampler2D Texture0;\n"
+            "void main()\n"
+            "{\n"
+            "   ivec2 pixel = ivec2(gl_FragCoord.xy);\n"
+            "   if (Shaded(pixel))\n"
+            "       discard;\n"
+            "   FragColor = texelFetch(Texture0, Source(pixel), 0);\n"
+            "   gl_FragDepth = 1.0;\n"
+            "}\n";
+
+        if (!InitPattern(Mask, Shaders.Get("", vertexSrc, patternSrc, maskSrc)) ||
+            !InitPattern(Fill, Shaders.Get("", vertexSrc, patternSrc, fillSrc)))
+        {
+            qWarning("Foveated rendering shaders failed to build, shading every pixel.");
+            Release();
+            return false;
+        }
+
+        // Core profiles draw nothing without a vertex array bound.
+        glGenVertexArrays(1, &VertexArray);
+        glGenFramebuffers(1, &CopyFbo);
+        return true;
+    }
+
+    bool InitPattern(Pattern &pattern, ShaderProgram * program)
+    {
+        if (!program)
+            return false;
+
+        pattern.Program = program;
+        pattern.EyeSizeLoc = glGetUniformLocation(program->program, "EyeSize");
+        pattern.CenterLoc = glGetUniformLocation(program->program, "Center");
+        pattern.RadiusLoc = glGetUniformLocation(program->program, "Radius");
+        pattern.FalloffLoc = glGetUniformLocation(program->program, "Falloff");
+        return true;
+    }
+
+    void Release()
+    {
+        Shaders.Release();
+        Mask = Pattern();
+        Fill = Pattern();
+
+        if (VertexArray)
+            glDeleteVertexArrays(1, &VertexArray);
+        if (CopyFbo)
+            glDeleteFramebuffers(1, &CopyFbo);
+        if (CopyTexture)
+            glDeleteTextures(1, &CopyTexture);
+        VertexArray = CopyFbo = CopyTexture = 0;
+        CopySize = QSize();
+    }
+
+    // viewportSize covers viewCount eyes side by side, centers are where
+    // each eye's projection axis lands, in normalized device coordinates.
+    void UsePattern(const Pattern &pattern, QSize viewportSize, int viewCount, const QVector2D centers[2], float radius, float falloff)
+    {
+        const GLfloat center[4] = { centers[0].x(), centers[0].y(), centers[1].x(), centers[1].y() };
+
+        glUseProgram(pattern.Program->program);
+        glUniform2f(pattern.EyeSizeLoc, GLfloat(viewportSize.width() / viewCount), GLfloat(viewportSize.height()));
+        glUniform2fv(pattern.CenterLoc, 2, center);
+        glUniform1f(pattern.RadiusLoc, radius);
+        glUniform1f(pattern.FalloffLoc, falloff);
+    }
+
+    // Right after the eye buffer is cleared, with it bound.
+    void DrawMask(QSize viewportSize, int viewCount, const QVector2D centers[2], float radius, float falloff)
+    {
+        UsePattern(Mask, viewportSize, viewCount, centers, radius, falloff);
+
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_ALWAYS);
+        glBindVertexArray(VertexArray);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        glDepthFunc(GL_LESS);
+        glDisable(GL_DEPTH_TEST);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glUseProgram(0);
+    }
+
+    // After the scene is drawn into eyeFbo.
+    void DrawFill(GLuint eyeFbo, QSize viewportSize, int viewCount, const QVector2D centers[2], float radius, float falloff)
+    {
+        if (CopySize != viewportSize)
+        {
+            if (CopyTexture)
+                glDeleteTextures(1, &CopyTexture);
+            glGenTextures(1, &CopyTexture);
+            glBindTexture(GL_TEXTURE_2D, CopyTexture);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, viewportSize.width(), viewportSize.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            glBindTexture(GL_TEXTURE_2D, 0);
+
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, CopyFbo);
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, CopyTexture, 0);
+            CopySize = viewportSize;
+        }
+
+        // The fill reads pixels of the target it writes, from a copy. sRGB
+        // encoding on both sides makes the round trip exact.
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, eyeFbo);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, CopyFbo);
+        glBlitFramebuffer(0, 0, viewportSize.width(), viewportSize.height(),
+                          0, 0, viewportSize.width(), viewportSize.height(),
+                          GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, eyeFbo);
+
+        UsePattern(Fill, viewportSize, viewCount, centers, radius, falloff);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, CopyTexture);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_ALWAYS);
+        glBindVertexArray(VertexArray);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        glDepthFunc(GL_LESS);
+        glDisable(GL_DEPTH_TEST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glUseProgram(0);
+    }
+};
+
+// A VRPanel's quad layer. Its layer texture is copied into the swap chain
+// whenever the scene graph re-rendered it; the compositor keeps showing the
+// last copy in between.
+struct PanelLayer
+{
+    VRPanelData                  Data;
+    QPointer<QSGTextureProvider> Provider;
+    QMetaObject::Connection      TextureChanged;
+    VRSwapChain                * SwapChain = nullptr;
+    bool                         Dirty = true;
+    bool                         Committed = false;
+
+    ~PanelLayer()
+    {
+        QObject::disconnect(TextureChanged);
+        delete SwapChain;
+    }
+};
+
+// The OpenGL name of a scene graph texture, with or without the RHI.
+static GLuint NativeTextureId(QSGTexture *texture)
+{
+    if (!texture)
+        return 0;
+
+    const QSGTexture::NativeTexture native = texture->nativeTexture();
+    if (native.object)
+        return *static_cast<const GLuint *>(native.object);
+    return texture->textureId();
+}
+
+VRRenderer::VRRenderer(QQuickWindow *window, VRFrameStatistics *statistics, QOffscreenSurface *textureSurface)
+    : m_window(window)
+    , textureSurface(textureSurface)
+    , frameStatistics(statistics)
+    , profiler(statistics)
+{
+
+    // Initializes the HMD runtime (LibOVR, or the simulated headset)
+    backend = VRBackend::create();
+    VALIDATE(backend->initialize(), "Failed to initialize the VR backend.");
+    qDebug("QuickVR backend\t = %s", backend->name());
+
+    QSGRendererInterface *rif = m_window->rendererInterface();
+    VALIDATE(rif->graphicsApi() == QSGRendererInterface::OpenGL || rif->graphicsApi() == QSGRendererInterface::OpenGLRhi, "Only OpenGL is supported at this time.");
+
+    initializeOpenGLFunctions();
+
+#ifndef NDEBUG
+    if (GL_ARB_debug_output)
+    {
+        PFNGLDEBUGMESSAGECALLBACKARBPROC glDebugMessageCallbackARB = (PFNGLDEBUGMESSAGECALLBACKARBPROC) QOpenGLContext::currentContext()->getProcAddress("glDebugMessageCallbackARB");
+        PFNGLDEBUGMESSAGECONTROLARBPROC glDebugMessageControlARB = (PFNGLDEBUGMESSAGECONTROLARBPROC) QOpenGLContext::currentContext()->getProcAddress("glDebugMessageControlARB");
+
+        if (glDebugMessageCallbackARB && glDebugMessageControlARB)
+        {
+            glDebugMessageCallbackARB(DebugGLCallback, NULL);
+            if (glGetError())
+            {
+                qCritical("glDebugMessageCallbackARB failed.\n");
+            }
+
+            glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_ARB);
+
+            // Explicitly disable notification severity output.
+            glDebugMessageControlARB(GL_DEBUG_SOURCE_API, GL_DONT_CARE, GL_DEBUG_SEVERITY_NOTIFICATION, 0, NULL, GL_FALSE);
+        }
+        else
+        {
+            qCritical("GL_ARB_debug_output extension not available.\n");
+        }
+    }
+#endif
+}
+
+VRRenderer::~VRRenderer()
+{
+    delete backend;
+    backend = nullptr;
+}
+
+void APIENTRY VRRenderer::DebugGLCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam)
+{
+    Q_UNUSED(source);
+    Q_UNUSED(type);
+    Q_UNUSED(id);
+    Q_UNUSED(severity);
+    Q_UNUSED(length);
+    Q_UNUSED(message);
+    Q_UNUSED(userParam);
+    qDebug("Message from OpenGL: %s\n", message);
+}
+
+void VRRenderer::computeViewProj(const VRPose eyePoses[2], const VRPose &origin, float zNear, float zFar, QMatrix4x4 viewProj[2]) const
+{
+    for (int eye = 0; eye < 2; ++eye)
+    {
+        QQuaternion finalRollPitchYaw = origin.Orientation * eyePoses[eye].Orientation;
+        QVector3D shiftedEyePos = origin.Position + origin.Orientation.rotatedVector(eyePoses[eye].Position);
+
+        QMatrix4x4 view = VRSimd::viewMatrix(finalRollPitchYaw.normalized(), shiftedEyePos);
+        QMatrix4x4 proj = backend->projection(eye, zNear, zFar);
+        viewProj[eye] = VRSimd::multiply(proj, view);
+    }
+}
+
+void VRRenderer::setResolutionScaleRange(float minimum, float maximum)
+{
+    resolutionScaler.setRange(minimum, maximum);
+    if (!sessionCreated)
+        allocatedScale = resolutionScaler.maximum();
+}
+
+// Feeds the last measured GPU frame time to the scaler and sizes this
+// frame's viewports. Eye buffers are allocated at the maximum scale of the
+// time the session was created, later maximums above that are clamped.
+void VRRenderer::updateResolutionScale()
+{
+    const qint64 gpuNs = profiler.takeGpuFrameTime();
+    if (gpuNs >= 0)
+        resolutionScaler.addGpuFrameTime(gpuNs);
+
+    const float scale = qMin(resolutionScaler.scale(), allocatedScale);
+    if (stereoRenderTexture)
+    {
+        const QSize eyeSize = ScaledSize(eyeBaseSize[0], scale);
+        stereoRenderTexture->SetViewportSize(QSize(eyeSize.width() * 2, eyeSize.height()));
+    }
+    else
+    {
+        for (int eye = 0; eye < 2; ++eye)
+            eyeRenderTexture[eye]->SetViewportSize(ScaledSize(eyeBaseSize[eye], scale));
+    }
+}
+
+double VRRenderer::predictedDisplayTime() const
+{
+    return sessionCreated ? backend->predictedDisplayTime(frameIndex) : -1.0;
+}
+
+void VRRenderer::init()
+{
+    if (m_fboId)
+    {
+        glGenFramebuffers(1, &m_fboId);
+    }
+
+    if (!sessionCreated)
+    {
+        if (!backend->createSession())
+            return;
+
+        sessionCreated = true;
+        frameStatistics->setRefreshRate(backend->refreshRate());
+        profiler.initialize();
+        resolutionScaler.setFrameBudget(qint64(1e9 / backend->refreshRate()));
+
+        // Make scene - can simplify further if needed
+        textureLoader = new VRTextureLoader(QOpenGLContext::currentContext(), textureSurface);
+        roomScene = new Scene(singlePassStereo, textureLoader);
+        for (const VRModelData &model : qAsConst(models))
+        {
+            roomScene->ApplyModel(model);
+        }
+
+        foveation = new Foveation;
+        if (!foveation->Init())
+        {
+            delete foveation;
+            foveation = nullptr;
+        }
+
+        // Make eye render buffers
+        if (roomScene->ViewCount > 1)
+        {
+            // Single pass stereo draws both eyes side by side in one target.
+            QSize eyeSize = backend->recommendedTextureSize(0).expandedTo(backend->recommendedTextureSize(1));
+            eyeBaseSize[0] = eyeBaseSize[1] = eyeSize;
+            eyeSize = ScaledSize(eyeSize, allocatedScale);
+            stereoRenderTexture = new EyeTextureBuffer(backend->createSwapChain(QSize(eyeSize.width() * 2, eyeSize.height()), true));
+
+            if (!stereoRenderTexture->SwapChain->isValid())
+            {
+                VALIDATE(false, "Failed to create texture.");
+            }
+        }
+        else
+        {
+            for (int eye = 0; eye < 2; ++eye)
+            {
+                eyeBaseSize[eye] = backend->recommendedTextureSize(eye);
+                eyeRenderTexture[eye] = new EyeTextureBuffer(backend->createSwapChain(ScaledSize(eyeBaseSize[eye], allocatedScale), true));
+
+                if (!eyeRenderTexture[eye]->SwapChain->isValid())
+                {
+                    VALIDATE(false, "Failed to create texture.");
+                }
+            }
+        }
+
+        // The first mirror doesn't wait for the window size to settle.
+        updateMirror();
+    }
+}
+
+void VRRenderer::setMirror(bool enabled, bool leftEyeOnly, float scale, int interval, bool toWindow)
+{
+    mirrorEnabled = enabled;
+    mirrorLeftEyeOnly = leftEyeOnly;
+    mirrorScale = qBound(0.05f, scale, 1.0f);
+    mirrorInterval = qMax(1, interval);
+    mirrorToWindow = toWindow;
+}
+
+void VRRenderer::updateMirror()
+{
+    if (!sessionCreated)
+        return;
+
+    if (!mirrorEnabled)
+    {
+        releaseMirror();
+        return;
+    }
+
+    // A minimized window keeps the mirror it had.
+    const QSize windowSize = m_window->size() * m_window->effectiveDevicePixelRatio();
+    if (windowSize.isEmpty())
+        return;
+
+    const QSize size = ScaledSize(windowSize, mirrorScale);
+    if (size == mirrorTextureSize && mirrorLeftEyeOnly == mirrorTextureLeftEyeOnly)
+    {
+        mirrorPendingFrames = 0;
+        return;
+    }
+
+    // The runtime refused this mirror already, ask again once it changes.
+    if (size == mirrorFailedSize && mirrorLeftEyeOnly == mirrorFailedLeftEyeOnly)
+        return;
+
+    // Wait for a resize to end, rather than recreating the runtime's mirror
+    // at every step of it. Switching eyes or turning it on is immediate.
+    if (size != mirrorPendingSize)
+    {
+        mirrorPendingSize = size;
+        mirrorPendingFrames = 0;
+    }
+    if (mirrorCopyTexture && mirrorLeftEyeOnly == mirrorTextureLeftEyeOnly && ++mirrorPendingFrames < kMirrorSettleFrames)
+        return;
+
+    releaseMirror();
+
+    GLuint texId = backend->createMirrorTexture(size, mirrorLeftEyeOnly);
+    if (!texId)
+    {
+        qWarning("QuickVR: failed to create a %dx%d mirror texture.", size.width(), size.height());
+        mirrorFailedSize = size;
+        mirrorFailedLeftEyeOnly = mirrorLeftEyeOnly;
+        return;
+    }
+    mirrorFailedSize = QSize();
+
+    glGenFramebuffers(1, &mirrorFBO);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, mirrorFBO);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texId, 0);
+    glFramebufferRenderbuffer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+    // Our own copy, in the same format so that the blits copy bytes. The
+    // scene graph writes what it samples straight to the window, so reads
+    // skip the sRGB decode where the context can.
+    glGenTextures(1, &mirrorCopyTexture);
+    glBindTexture(GL_TEXTURE_2D, mirrorCopyTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    if (QOpenGLContext::currentContext()->hasExtension("GL_EXT_texture_sRGB_decode"))
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_SRGB_DECODE_EXT, GL_SKIP_DECODE_EXT);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, size.width(), size.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &mirrorCopyFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, mirrorCopyFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mirrorCopyTexture, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    mirrorTextureSize = size;
+    mirrorTextureLeftEyeOnly = mirrorLeftEyeOnly;
+    mirrorPendingFrames = 0;
+    mirrorCopiedFrame = -1;
+}
+
+void VRRenderer::releaseMirror()
+{
+    if (mirrorFBO)
+    {
+        glDeleteFramebuffers(1, &mirrorFBO);
+        mirrorFBO = 0;
+    }
+    if (mirrorCopyFBO)
+    {
+        glDeleteFramebuffers(1, &mirrorCopyFBO);
+        mirrorCopyFBO = 0;
+    }
+    if (mirrorCopyTexture)
+    {
+        glDeleteTextures(1, &mirrorCopyTexture);
+        mirrorCopyTexture = 0;
+    }
+    backend->destroyMirrorTexture();
+    mirrorTextureSize = QSize();
+}
+
+void VRRenderer::paint()
+{
+    //qDebug() << "context swap interval =" << QOpenGLContext::currentContext()->format().swapInterval();
+
+    if (!sessionCreated)
+        return;
+
+    profiler.beginFrame(frameIndex);
+
+    // Play nice with the RHI. Not strictly needed when the scenegraph uses
+    // OpenGL directly.
+    m_window->beginExternalCommands();
+
+    profiler.begin(VRFrameStatistics::SessionStatus);
+    VRSessionStatus sessionStatus = backend->sessionStatus();
+    profiler.end(VRFrameStatistics::SessionStatus);
+    if (sessionStatus.ShouldQuit)
+    {
+        profiler.abortFrame();
+        m_window->endExternalCommands();
+
+        // Because the application is requested to quit, should not request retry
+        if (!quitRequested)
+        {
+            quitRequested = true;
+
+            VRFrameStatistics::Summary summary = frameStatistics->summarize();
+            for (int phase = 0; phase < VRFrameStatistics::PhaseCount; ++phase)
+            {
+                const VRFrameStatistics::Percentiles &cpu = summary.Cpu[phase];
+                const VRFrameStatistics::Percentiles &gpu = summary.Gpu[phase];
+                qDebug("%-16s cpu p50 %7.3f p95 %7.3f p99 %7.3f ms | gpu p50 %7.3f p95 %7.3f p99 %7.3f ms",
+                       VRFrameStatistics::phaseName(VRFrameStatistics::Phase(phase)),
+                       cpu.P50, cpu.P95, cpu.P99, gpu.P50, gpu.P95, gpu.P99);
+            }
+            qDebug("%d frames, %.1f%% over the %.3f ms budget", summary.SampleCount,
+                   summary.OverBudgetRatio * 100.0, summary.FrameBudget);
+            qDebug("%d GL calls per frame: %d draws, %d state changes, %d uniform uploads",
+                   summary.Calls.total(), summary.Calls.DrawCalls, summary.Calls.StateChanges,
+                   summary.Calls.UniformUploads);
+            qDebug("%d models culled", summary.Calls.Culled);
+            if (summary.ShadedSamples > 0.0)
+                qDebug("%.0f samples shaded per frame", summary.ShadedSamples);
+
+            QMetaObject::invokeMethod(QCoreApplication::instance(), "quit", Qt::QueuedConnection);
+        }
+        return;
+    }
+    if (sessionStatus.ShouldRecenter)
+        backend->recenter();
+
+    updateResolutionScale();
+    applyModelChanges();
+    roomScene->UpdateTransforms();
+    roomScene->UpdateImports();
+    roomScene->UpdateTextures();
+
+    if (sessionStatus.IsVisible)
+    {
+        // Get eye poses, including the IPD offset
+        VRPose EyeRenderPose[2];
+        double sensorSampleTime;    // sensorSampleTime is fed into the layer later
+        profiler.begin(VRFrameStatistics::EyePoses);
+        backend->getEyePoses(frameIndex, EyeRenderPose, &sensorSampleTime);
+        profiler.end(VRFrameStatistics::EyePoses);
+
+        const float zNear = 0.2f;
+        const float zFar = 1000.0f;
+
+        // Get view and projection matrices
+        const VRPose origin = originPose.latest();
+        QMatrix4x4 viewProj[2];
+        computeViewProj(EyeRenderPose, origin, zNear, zFar, viewProj);
+
+        if (lateLatching)
+        {
+            // The head keeps turning until the late sample, cull against
+            // wider frusta so nothing pops in at the edges. 0.9 widens a 90
+            // degree field of view by about 3 degrees on each side.
+            const float cullScale = 0.9f;
+            QMatrix4x4 widen;
+            widen.scale(cullScale, cullScale, 1.0f);
+            QMatrix4x4 cullViewProj[2] = { widen * viewProj[0], widen * viewProj[1] };
+            roomScene->Cull(cullViewProj, frustumCulling, profiler.counters());
+        }
+        else
+        {
+            roomScene->Cull(viewProj, frustumCulling, profiler.counters());
+        }
+        roomScene->PrepareFrame();
+
+        if (lateLatching)
+        {
+            // Same frame index, so the same predicted display time, but a
+            // newer tracking sample. The layer is submitted with these poses
+            // so the compositor's timewarp corrects from the right place.
+            profiler.begin(VRFrameStatistics::EyePoses);
+            backend->getEyePoses(frameIndex, EyeRenderPose, &sensorSampleTime);
+            profiler.end(VRFrameStatistics::EyePoses);
+            computeViewProj(EyeRenderPose, origin, zNear, zFar, viewProj);
+        }
+        roomScene->SetCamera(viewProj);
+
+        // The fovea follows each eye's projection axis, off center on
+        // headsets with asymmetric frusta.
+        const bool foveate = foveated && foveation;
+        QVector2D foveaCenter[2];
+        if (foveate)
+        {
+            for (int eye = 0; eye < 2; ++eye)
+            {
+                const QVector4D axis = backend->projection(eye, zNear, zFar) * QVector4D(0.0f, 0.0f, -1.0f, 1.0f);
+                foveaCenter[eye] = axis.toVector2D() / axis.w();
+            }
+        }
+
+        // Draws the scene into the bound eye buffer, eye being -1 for both.
+        const auto renderScene = [&](EyeTextureBuffer *target, int eye, VRFrameStatistics::Phase phase) {
+            const int viewCount = eye < 0 ? 2 : 1;
+            const QVector2D centers[2] = { foveaCenter[qMax(eye, 0)], foveaCenter[eye < 0 ? 1 : eye] };
+            if (foveate)
+                foveation->DrawMask(target->GetViewportSize(), viewCount, centers, foveaRadius, foveaFalloff);
+
+            profiler.beginSamples(phase);
+            roomScene->Render(qMax(eye, 0), profiler.counters());
+            profiler.endSamples(phase);
+
+            if (foveate)
+                foveation->DrawFill(target->fboId, target->GetViewportSize(), viewCount, centers, foveaRadius, foveaFalloff);
+        };
+
+        // Render Scene to Eye Buffers
+        if (stereoRenderTexture)
+        {
+            profiler.begin(VRFrameStatistics::RenderStereo);
+
+            stereoRenderTexture->SetAndClearRenderSurface();
+            renderScene(stereoRenderTexture, -1, VRFrameStatistics::RenderStereo);
+            stereoRenderTexture->UnsetRenderSurface();
+
+            profiler.end(VRFrameStatistics::RenderStereo);
+
+            profiler.begin(VRFrameStatistics::Commit);
+            stereoRenderTexture->Commit();
+            profiler.end(VRFrameStatistics::Commit);
+        }
+        else
+        {
+            for (int eye = 0; eye < 2; ++eye)
+            {
+                const VRFrameStatistics::Phase renderPhase = eye == 0 ? VRFrameStatistics::RenderLeftEye : VRFrameStatistics::RenderRightEye;
+                profiler.begin(renderPhase);
+
+                // Switch to eye render target
+                eyeRenderTexture[eye]->SetAndClearRenderSurface();
+
+                // Render world
+                renderScene(eyeRenderTexture[eye], eye, renderPhase);
+
+                // Avoids an error when calling SetAndClearRenderSurface during next iteration.
+                // Without this, during the next while loop iteration SetAndClearRenderSurface
+                // would bind a framebuffer with an invalid COLOR_ATTACHMENT0 because the texture ID
+                // associated with COLOR_ATTACHMENT0 had been unlocked by calling wglDXUnlockObjectsNV.
+                eyeRenderTexture[eye]->UnsetRenderSurface();
+
+                profiler.end(renderPhase);
+
+                // Commit changes to the textures so they get picked up frame
+                profiler.begin(VRFrameStatistics::Commit);
+                eyeRenderTexture[eye]->Commit();
+                profiler.end(VRFrameStatistics::Commit);
+            }
+        }
+
+        // Do distortion rendering, Present and flush/sync
+
+        VREyeLayer ld;
+        ld.SensorSampleTime = sensorSampleTime;
+        ld.ZNear = zNear;
+        ld.ZFar = zFar;
+
+        for (int eye = 0; eye < 2; ++eye)
+        {
+            // Scaled down viewports are upsampled by the compositor.
+            if (stereoRenderTexture)
+            {
+                QSize size = stereoRenderTexture->GetViewportSize();
+                ld.SwapChain[eye] = stereoRenderTexture->SwapChain;
+                ld.Viewport[eye]  = QRect(eye * size.width() / 2, 0, size.width() / 2, size.height());
+            }
+            else
+            {
+                ld.SwapChain[eye] = eyeRenderTexture[eye]->SwapChain;
+                ld.Viewport[eye]  = QRect(QPoint(0, 0), eyeRenderTexture[eye]->GetViewportSize());
+            }
+            ld.RenderPose[eye]   = EyeRenderPose[eye];
+        }
+
+        // The panels' layers were re-rendered, if they changed, before this
+        // in the scene graph's preprocess step. Copying them into the swap
+        // chains is GPU work, it counts towards the frame time the
+        // resolution scaler sees.
+        QVector<VRQuadLayer> quads;
+        profiler.begin(VRFrameStatistics::Panels);
+        updatePanels(origin, quads);
+        profiler.end(VRFrameStatistics::Panels);
+
+        profiler.begin(VRFrameStatistics::SubmitFrame);
+        bool submitted = backend->submitFrame(frameIndex, ld, quads);
+        profiler.end(VRFrameStatistics::SubmitFrame);
+
+        // exit the rendering loop if submit returns an error, will retry on ovrError_DisplayLost
+        if (!submitted)
+        {
+            profiler.abortFrame();
+            m_window->endExternalCommands();
+            return;
+        }
+
+        frameIndex++;
+    }
+
+    // Refresh our copy of the mirror texture every mirrorInterval frames,
+    // and blit it to the back buffer, stretched if it is scaled down or the
+    // window is being resized.
+    if (mirrorCopyTexture)
+    {
+        profiler.begin(VRFrameStatistics::MirrorBlit);
+        GLint w = mirrorTextureSize.width();
+        GLint h = mirrorTextureSize.height();
+        if (mirrorCopiedFrame < 0 || frameIndex - mirrorCopiedFrame >= mirrorInterval)
+        {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, mirrorFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, mirrorCopyFBO);
+            glBlitFramebuffer(0, 0, w, h,
+                              0, 0, w, h,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            mirrorCopiedFrame = frameIndex;
+        }
+        if (mirrorToWindow)
+        {
+            const QSize windowSize = m_window->size() * m_window->effectiveDevicePixelRatio();
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, mirrorCopyFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, h, w, 0,
+                              0, 0, windowSize.width(), windowSize.height(),
+                              GL_COLOR_BUFFER_BIT, windowSize == mirrorTextureSize ? GL_NEAREST : GL_LINEAR);
+        }
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        profiler.end(VRFrameStatistics::MirrorBlit);
+    }
+
+    // Not strictly needed for this example, but generally useful for when
+    // mixing with raw OpenGL.
+    m_window->resetOpenGLState();
+
+    m_window->endExternalCommands();
+
+    profiler.endFrame();
+
+    // Keep the scene tree dirty so that it renders at every frame. It's not a
+    // UI. It's a VR app. We don't need this CPU usage optimization.
+    m_window->update();
+}
+
+void VRRenderer::setPanels(const QVector<VRPanelData> &newPanels)
+{
+    QHash<quint64, PanelLayer *> previous;
+    previous.swap(panels);
+
+    for (const VRPanelData &data : newPanels)
+    {
+        PanelLayer *panel = previous.take(data.Id);
+        if (!panel)
+        {
+            panel = new PanelLayer;
+        }
+        panel->Data = data;
+
+        // The layer's provider comes and goes with the scene graph.
+        if (panel->Provider != data.Provider)
+        {
+            QObject::disconnect(panel->TextureChanged);
+            panel->Provider = data.Provider;
+            panel->Dirty = true;
+            if (data.Provider)
+            {
+                panel->TextureChanged = connect(data.Provider, &QSGTextureProvider::textureChanged, this, [panel]() {
+                    panel->Dirty = true;
+                }, Qt::DirectConnection);
+            }
+        }
+
+        panels.insert(data.Id, panel);
+    }
+
+    qDeleteAll(previous);
+}
+
+void VRRenderer::updatePanels(const VRPose &origin, QVector<VRQuadLayer> &quads)
+{
+    const QQuaternion sceneToTracking = origin.Orientation.conjugated();
+
+    for (PanelLayer *panel : qAsConst(panels))
+    {
+        QSGTexture *texture = panel->Provider ? panel->Provider->texture() : nullptr;
+        const GLuint textureId = NativeTextureId(texture);
+        if (!textureId)
+            continue;
+
+        const QSize size = texture->textureSize();
+        if (size.isEmpty())
+            continue;
+
+        if (!panel->SwapChain || panel->SwapChain->size() != size)
+        {
+            delete panel->SwapChain;
+            panel->SwapChain = backend->createSwapChain(size, false);
+            panel->Dirty = true;
+            panel->Committed = false;
+            if (!panel->SwapChain->isValid())
+            {
+                qWarning("QuickVR: failed to create a %dx%d panel texture.", size.width(), size.height());
+            }
+        }
+        if (!panel->SwapChain->isValid())
+            continue;
+
+        if (panel->Dirty)
+        {
+            if (!panelFBO[0])
+            {
+                glGenFramebuffers(2, panelFBO);
+            }
+
+            // The layer is top row first, the swap chain bottom row first.
+            // A plain byte copy, the items' colors are sRGB encoded already.
+            const GLint w = size.width();
+            const GLint h = size.height();
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, panelFBO[0]);
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureId, 0);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, panelFBO[1]);
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, panel->SwapChain->currentColorTexture(), 0);
+            glDisable(GL_FRAMEBUFFER_SRGB);
+            glDisable(GL_SCISSOR_TEST);
+            glBlitFramebuffer(0, 0, w, h,
+                              0, h, w, 0,
+                              GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+            panel->SwapChain->commit();
+            panel->Dirty = false;
+            panel->Committed = true;
+        }
+
+        if (!panel->Committed)
+            continue;
+
+        const VRPanelData &data = panel->Data;
+        VRQuadLayer quad;
+        quad.SwapChain = panel->SwapChain;
+        quad.Viewport = QRect(QPoint(0, 0), size);
+        quad.Size = QSizeF(data.Width, data.Width * size.height() / size.width());
+        quad.HeadLocked = data.HeadLocked;
+        if (data.HeadLocked)
+        {
+            quad.Pose = data.Pose;
+        }
+        else
+        {
+            quad.Pose.Orientation = sceneToTracking * data.Pose.Orientation;
+            quad.Pose.Position = sceneToTracking.rotatedVector(data.Pose.Position - origin.Position);
+        }
+        quads.append(quad);
+    }
+}
+
+void VRRenderer::releasePanels()
+{
+    qDeleteAll(panels);
+    panels.clear();
+
+    if (panelFBO[0])
+    {
+        glDeleteFramebuffers(2, panelFBO);
+        panelFBO[0] = panelFBO[1] = 0;
+    }
+}
+
+void VRRenderer::queueModelChanges(const QVector<VRModelData> &changes)
+{
+    pendingModelChanges += changes;
+}
+
+void VRRenderer::applyModelChanges()
+{
+    for (const VRModelData &change : qAsConst(pendingModelChanges))
+    {
+        if (change.Removed)
+        {
+            models.remove(change.Id);
+        }
+        else
+        {
+            VRModelData &model = models[change.Id];
+            model.Id = change.Id;
+            model.ParentId = change.ParentId;
+            model.Transform = change.Transform;
+            if (change.GeometryChanged)
+            {
+                model.Pattern = change.Pattern;
+                model.Texture = change.Texture;
+                model.Mesh = change.Mesh;
+                model.Dynamic = change.Dynamic;
+                model.Instanced = change.Instanced;
+                model.Boxes = change.Boxes;
+            }
+            // Stored copies are replayed as a whole when the scene is rebuilt.
+            model.GeometryChanged = true;
+        }
+
+        if (roomScene)
+        {
+            roomScene->ApplyModel(change);
+        }
+    }
+    pendingModelChanges.clear();
+}
+
+void VRRenderer::cleanup()
+{
+    if (roomScene)
+    {
+        delete roomScene;
+        roomScene = nullptr;
+    }
+
+    delete textureLoader;
+    textureLoader = nullptr;
+
+    if (foveation)
+    {
+        foveation->Release();
+        delete foveation;
+        foveation = nullptr;
+    }
+
+    releaseMirror();
+    releasePanels();
+
+    for (int eye = 0; eye < 2; ++eye)
+    {
+        delete eyeRenderTexture[eye];
+        eyeRenderTexture[eye] = nullptr;
+    }
+
+    delete stereoRenderTexture;
+    stereoRenderTexture = nullptr;
+
+    if (m_fboId)
+    {
+        glDeleteFramebuffers(1, &m_fboId);
+        m_fboId = 0;
+    }
+
+    profiler.release();
+
+    backend->destroySession();
+    sessionCreated = false;
+}
+
@@ -0,0 +1,142 @@
+#ifndef VRRENDERER_H
+#define VRRENDERER_H
+
+#include <QtCore/QHash>
+#include <QtQuick/QQuickWindow>
+#include <QtGui/QOpenGLShaderProgram>
+#include <QtGui/QOpenGLExtraFunctions>
+#include <QtGui/QVector3D>
+
+#include "VRBackend.h"
+#include "VRFrameProfiler.h"
+#include "VRModel.h"
+#include "VRPanel.h"
+#include "VRPoseChannel.h"
+#include "VRResolutionScaler.h"
+
+class QOffscreenSurface;
+class VRTextureLoader;
+struct EyeTextureBuffer;
+struct Foveation;
+struct PanelLayer;
+struct Scene;
+
+class VRRenderer : public QObject, protected QOpenGLExtraFunctions
+{
+    Q_OBJECT
+public:
+    // textureSurface is used by the texture upload thread, it must be
+    // created on the GUI thread.
+    VRRenderer(QQuickWindow *window, VRFrameStatistics *statistics, QOffscreenSurface *textureSurface);
+    ~VRRenderer();
+
+    static void APIENTRY DebugGLCallback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar* message, const void* userParam);
+
+public slots:
+    void init();
+    void paint();
+    void cleanup();
+
+public:
+    // Takes effect the next time the scene graph is initialized.
+    void setSinglePassStereo(bool enabled) { singlePassStereo = enabled; }
+    void setFrustumCulling(bool enabled) { frustumCulling = enabled; }
+    void setLateLatching(bool enabled) { lateLatching = enabled; }
+    void setFoveation(bool enabled, float radius, float falloff) { foveated = enabled; foveaRadius = radius; foveaFalloff = falloff; }
+
+    // Bounds of the adaptive eye buffer scale. The buffers are allocated at
+    // the maximum when the session is created.
+    void setResolutionScaleRange(float minimum, float maximum);
+    float resolutionScale() const { return qMin(resolutionScaler.scale(), allocatedScale); }
+
+    // Called from VRWindow::sync() while the GUI thread is blocked. The
+    // changes are applied to the scene at the start of the next frame.
+    void queueModelChanges(const QVector<VRModelData> &changes);
+
+    // Called from VRWindow::sync() every frame with all of the window's
+    // panels. Panels missing from the list are released.
+    void setPanels(const QVector<VRPanelData> &newPanels);
+
+    // Where the tracking origin is in the scene. Called from any one thread
+    // at a time, picked up by the next frame.
+    void setOriginPose(const VRPose &pose) { originPose.publish(pose); }
+
+    // Predicted display time of the frame about to be rendered, in seconds,
+    // or -1 while there is no session. Render thread only.
+    double predictedDisplayTime() const;
+
+    // The desktop mirror: the compositor output at scale times the window
+    // size, copied into mirrorTexture() every interval frames and blitted
+    // to the window each frame when toWindow is set. Disabled, the runtime
+    // isn't asked for a mirror at all.
+    void setMirror(bool enabled, bool leftEyeOnly, float scale, int interval, bool toWindow);
+
+    // Recreates the mirror once the window size, scale or eyes changed and
+    // the size stopped changing. Render thread, before the scene graph
+    // syncs, so that items pick up the new texture in the same frame.
+    void updateMirror();
+
+    // sRGB encoded but sampled without decoding, top row first. 0 while
+    // there is no mirror. Render thread only.
+    GLuint mirrorTexture() const { return mirrorCopyTexture; }
+    QSize mirrorSize() const { return mirrorTextureSize; }
+
+private:
+    void applyModelChanges();
+    void updateResolutionScale();
+    void releaseMirror();
+    void updatePanels(const VRPose &origin, QVector<VRQuadLayer> &quads);
+    void releasePanels();
+    void computeViewProj(const VRPose eyePoses[2], const VRPose &origin, float zNear, float zFar, QMatrix4x4 viewProj[2]) const;
+
+    QQuickWindow *m_window;
+    GLuint m_fboId = 0;
+
+    VRBackend     * backend = nullptr;
+    EyeTextureBuffer * eyeRenderTexture[2] = { nullptr, nullptr };
+    EyeTextureBuffer * stereoRenderTexture = nullptr;
+    GLuint          mirrorFBO = 0;          // reads the backend's mirror texture
+    GLuint          mirrorCopyFBO = 0;
+    GLuint          mirrorCopyTexture = 0;
+    Scene         * roomScene = nullptr;
+    Foveation     * foveation = nullptr;
+    QOffscreenSurface * textureSurface;
+    VRTextureLoader * textureLoader = nullptr;
+    long long frameIndex = 0;
+    bool sessionCreated = false;
+    bool singlePassStereo = true;
+    bool frustumCulling = true;
+    bool lateLatching = true;
+    bool foveated = false;
+    float foveaRadius = 0.5f;
+    float foveaFalloff = 0.3f;
+    bool mirrorEnabled = true;
+    bool mirrorLeftEyeOnly = false;
+    float mirrorScale = 1.0f;
+    int mirrorInterval = 1;
+    bool mirrorToWindow = true;
+    QSize mirrorTextureSize;            // of the mirror that exists
+    bool mirrorTextureLeftEyeOnly = false;
+    QSize mirrorPendingSize;            // of the one to create once resizing stops
+    int mirrorPendingFrames = 0;
+    QSize mirrorFailedSize;             // of the last one the backend refused
+    bool mirrorFailedLeftEyeOnly = false;
+    long long mirrorCopiedFrame = -1;
+
+    VRFrameStatistics * frameStatistics;
+    VRFrameProfiler profiler;
+    VRResolutionScaler resolutionScaler;
+    float allocatedScale = 1.0f;
+    QSize eyeBaseSize[2];       // recommended sizes, scale 1
+    bool quitRequested = false;
+
+    QVector<VRModelData> pendingModelChanges;
+    QHash<quint64, VRModelData> models;     // to rebuild the scene after cleanup()
+
+    QHash<quint64, PanelLayer *> panels;
+    GLuint panelFBO[2] = { 0, 0 };          // read, draw
+
+    VRPoseChannel originPose;
+};
+
+#endif // VRRENDERER_H
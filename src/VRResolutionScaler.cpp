@@ -0,0 +1,84 @@
+#include "VRResolutionScaler.h"
+
+#include <QtCore/QtMath>
+
+namespace {
+
+// Fractions of the frame budget. Above kTargetLoad on average, or above
+// kDropLoad for a single frame, the scale drops so that the GPU time lands on
+// kTargetLoad. Below kRaiseLoad for kRaiseFrames frames it goes up a step.
+const double kTargetLoad = 0.8;
+const double kDropLoad = 0.9;
+const double kRaiseLoad = 0.65;
+const int kRaiseFrames = 45;
+const float kRaiseStep = 0.05f;
+
+const double kSmoothing = 0.1;
+
+// More than VRFrameProfiler's query latency.
+const int kIgnoredFrames = 6;
+
+// Viewports change in steps of 1/64 of the full size, not every frame.
+const float kQuantum = 1.0f / 64.0f;
+
+} // namespace
+
+void VRResolutionScaler::setRange(float minimum, float maximum)
+{
+    m_minimum = qMax(0.1f, qMin(minimum, maximum));
+    m_maximum = qMax(m_minimum, maximum);
+    setScale(m_scale);
+}
+
+bool VRResolutionScaler::addGpuFrameTime(qint64 ns)
+{
+    if (m_budgetNs <= 0 || m_minimum == m_maximum)
+        return false;
+
+    if (m_ignoredFrames > 0)
+    {
+        --m_ignoredFrames;
+        return false;
+    }
+
+    m_averageNs = m_averageNs < 0.0 ? double(ns) : m_averageNs + (double(ns) - m_averageNs) * kSmoothing;
+
+    const double budget = double(m_budgetNs);
+    const double worst = qMax(double(ns), m_averageNs);
+    if (ns > kDropLoad * budget || m_averageNs > kTargetLoad * budget)
+    {
+        // GPU time goes roughly with the pixel count, the square of the scale.
+        // Rounded down and by at least one quantum, a drop rounded to the
+        // nearest step would leave a load just above the target uncorrected.
+        m_headroomFrames = 0;
+        const float scale = m_scale * float(qSqrt(kTargetLoad * budget / worst));
+        return setScale(qMin(qFloor(scale / kQuantum) * kQuantum, m_scale - kQuantum));
+    }
+
+    if (m_averageNs < kRaiseLoad * budget && m_scale < m_maximum)
+    {
+        if (++m_headroomFrames >= kRaiseFrames)
+        {
+            m_headroomFrames = 0;
+            return setScale(m_scale + kRaiseStep);
+        }
+    }
+    else
+    {
+        m_headroomFrames = 0;
+    }
+    return false;
+}
+
+bool VRResolutionScaler::setScale(float scale)
+{
+    scale = qBound(m_minimum, qRound(scale / kQuantum) * kQuantum, m_maximum);
+    if (scale == m_scale)
+        return false;
+
+    // Frames still in flight were drawn at the old scale.
+    m_scale = scale;
+    m_averageNs = -1.0;
+    m_ignoredFrames = kIgnoredFrames;
+    return true;
+}
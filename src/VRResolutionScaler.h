@@ -0,0 +1,39 @@
+#ifndef VRRESOLUTIONSCALER_H
+#define VRRESOLUTIONSCALER_H
+
+#include <QtCore/QtGlobal>
+
+// Picks the eye buffer resolution scale from measured GPU frame times, to
+// keep them under the refresh budget. Drops as soon as a frame gets close
+// to the budget, by as much as the pixel count needs to shrink, and climbs
+// back in small steps once there has been headroom for a while. Timer query
+// results trail the frames they measure, so the results of the frames right
+// after a change are ignored.
+//
+// Scales apply to both axes; 0.5 draws a quarter of the pixels.
+class VRResolutionScaler
+{
+public:
+    void setRange(float minimum, float maximum);
+    void setFrameBudget(qint64 ns) { m_budgetNs = ns; }
+
+    float maximum() const { return m_maximum; }
+    float scale() const { return m_scale; }
+
+    // Feeds the GPU time of one frame. Returns true when scale() changed.
+    bool addGpuFrameTime(qint64 ns);
+
+private:
+    bool setScale(float scale);
+
+    float m_minimum = 0.5f;
+    float m_maximum = 1.0f;
+    float m_scale = 1.0f;
+    qint64 m_budgetNs = 0;
+
+    double m_averageNs = -1.0;
+    int m_ignoredFrames = 0;
+    int m_headroomFrames = 0;
+};
+
+#endif // VRRESOLUTIONSCALER_H
@@ -0,0 +1,154 @@
+#ifndef VRSIMD_H
+#define VRSIMD_H
+
+#include <QtGui/QMatrix4x4>
+#include <QtGui/QQuaternion>
+#include <QtGui/QVector3D>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define VR_SIMD_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#  include <arm_neon.h>
+#  define VR_SIMD_NEON 1
+#endif
+
+// Four float lanes for the transform and culling math: SSE2 on x86 (part
+// of every x86-64 target), NEON on ARM, plain loops elsewhere. A 4x4 column
+// major matrix, QMatrix4x4's storage, is exactly four of them, so wider
+// vectors would not help the single matrix operations below. (No min and
+// max: windows.h may have defined them as macros.)
+namespace VRSimd {
+
+#if VR_SIMD_SSE
+
+typedef __m128 Float4;
+
+inline Float4 load(const float *p) { return _mm_loadu_ps(p); }
+inline void store(float *p, Float4 v) { _mm_storeu_ps(p, v); }
+inline Float4 set(float x, float y, float z, float w) { return _mm_setr_ps(x, y, z, w); }
+inline Float4 splat(float v) { return _mm_set1_ps(v); }
+template <int Lane> inline Float4 splat(Float4 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(Lane, Lane, Lane, Lane)); }
+inline Float4 add(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 sub(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 mul(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 minimum(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+inline Float4 maximum(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+inline Float4 abs(Float4 v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+inline bool anyNegative(Float4 v) { return _mm_movemask_ps(_mm_cmplt_ps(v, _mm_setzero_ps())) != 0; }
+
+#elif VR_SIMD_NEON
+
+typedef float32x4_t Float4;
+
+inline Float4 load(const float *p) { return vld1q_f32(p); }
+inline void store(float *p, Float4 v) { vst1q_f32(p, v); }
+inline Float4 set(float x, float y, float z, float w) { const float v[4] = { x, y, z, w }; return vld1q_f32(v); }
+inline Float4 splat(float v) { return vdupq_n_f32(v); }
+template <int Lane> inline Float4 splat(Float4 v) { return vdupq_n_f32(vgetq_lane_f32(v, Lane)); }
+inline Float4 add(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 sub(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+inline Float4 mul(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+inline Float4 minimum(Float4 a, Float4 b) { return vminq_f32(a, b); }
+inline Float4 maximum(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+inline Float4 abs(Float4 v) { return vabsq_f32(v); }
+inline bool anyNegative(Float4 v)
+{
+    const uint32x4_t negative = vcltq_f32(v, vdupq_n_f32(0.0f));
+    const uint32x2_t folded = vorr_u32(vget_low_u32(negative), vget_high_u32(negative));
+    return (vget_lane_u32(folded, 0) | vget_lane_u32(folded, 1)) != 0;
+}
+
+#else
+
+struct Float4 { float v[4]; };
+
+inline Float4 load(const float *p) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = p[i]; return r; }
+inline void store(float *p, Float4 v) { for (int i = 0; i < 4; ++i) p[i] = v.v[i]; }
+inline Float4 set(float x, float y, float z, float w) { Float4 r = { { x, y, z, w } }; return r; }
+inline Float4 splat(float v) { return set(v, v, v, v); }
+template <int Lane> inline Float4 splat(Float4 v) { return splat(v.v[Lane]); }
+inline Float4 add(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+inline Float4 sub(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+inline Float4 mul(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+inline Float4 minimum(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = qMin(a.v[i], b.v[i]); return a; }
+inline Float4 maximum(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = qMax(a.v[i], b.v[i]); return a; }
+inline Float4 abs(Float4 v) { for (int i = 0; i < 4; ++i) v.v[i] = qAbs(v.v[i]); return v; }
+inline bool anyNegative(Float4 v) { return v.v[0] < 0.0f || v.v[1] < 0.0f || v.v[2] < 0.0f || v.v[3] < 0.0f; }
+
+#endif
+
+// out = a * b for column major 4x4 matrices. out must not alias a or b.
+inline void multiply(const float *a, const float *b, float *out)
+{
+    const Float4 a0 = load(a), a1 = load(a + 4), a2 = load(a + 8), a3 = load(a + 12);
+    for (int column = 0; column < 4; ++column)
+    {
+        const Float4 b0 = load(b + 4 * column);
+        const Float4 r = add(mul(a0, splat<0>(b0)), mul(a1, splat<1>(b0)));
+        store(out + 4 * column, add(r, add(mul(a2, splat<2>(b0)), mul(a3, splat<3>(b0)))));
+    }
+}
+
+// QMatrix4x4's own operator* checks its type flags first, and multiplies
+// general matrices one scalar at a time.
+inline QMatrix4x4 multiply(const QMatrix4x4 &a, const QMatrix4x4 &b)
+{
+    QMatrix4x4 result(Qt::Uninitialized);
+    multiply(a.constData(), b.constData(), result.data());
+    return result;
+}
+
+// out[i] = a * b[i], with a loaded once.
+inline void multiply(const QMatrix4x4 &a, const QMatrix4x4 *b, QMatrix4x4 *out, int count)
+{
+    const float *m = a.constData();
+    const Float4 a0 = load(m), a1 = load(m + 4), a2 = load(m + 8), a3 = load(m + 12);
+    for (int i = 0; i < count; ++i)
+    {
+        const float *in = b[i].constData();
+        float *result = out[i].data();
+        for (int column = 0; column < 4; ++column)
+        {
+            const Float4 b0 = load(in + 4 * column);
+            const Float4 r = add(mul(a0, splat<0>(b0)), mul(a1, splat<1>(b0)));
+            store(result + 4 * column, add(r, add(mul(a2, splat<2>(b0)), mul(a3, splat<3>(b0)))));
+        }
+    }
+}
+
+// Rotation by orientation, then translation by position. orientation must
+// be normalized.
+inline QMatrix4x4 poseMatrix(const QQuaternion &orientation, const QVector3D &position)
+{
+    const float x = orientation.x(), y = orientation.y(), z = orientation.z(), w = orientation.scalar();
+    const float xx = x * x, yy = y * y, zz = z * z;
+    const float xy = x * y, xz = x * z, yz = y * z;
+    const float wx = w * x, wy = w * y, wz = w * z;
+
+    QMatrix4x4 m(Qt::Uninitialized);
+    float *d = m.data();
+    d[0]  = 1.0f - 2.0f * (yy + zz); d[1]  = 2.0f * (xy + wz);        d[2]  = 2.0f * (xz - wy);        d[3]  = 0.0f;
+    d[4]  = 2.0f * (xy - wz);        d[5]  = 1.0f - 2.0f * (xx + zz); d[6]  = 2.0f * (yz + wx);        d[7]  = 0.0f;
+    d[8]  = 2.0f * (xz + wy);        d[9]  = 2.0f * (yz - wx);        d[10] = 1.0f - 2.0f * (xx + yy); d[11] = 0.0f;
+    d[12] = position.x();            d[13] = position.y();            d[14] = position.z();            d[15] = 1.0f;
+    return m;
+}
+
+// The view matrix of a camera at that pose: the inverse of poseMatrix(),
+// the same matrix QMatrix4x4::lookAt() builds from the pose's forward and
+// up vectors, without normalizing and crossing them.
+inline QMatrix4x4 viewMatrix(const QQuaternion &orientation, const QVector3D &position)
+{
+    QMatrix4x4 m = poseMatrix(orientation.conjugated(), QVector3D());
+    const QVector3D t = -m.map(position);
+    float *d = m.data();
+    d[12] = t.x();
+    d[13] = t.y();
+    d[14] = t.z();
+    return m;
+}
+
+} // namespace VRSimd
+
+#endif // VRSIMD_H
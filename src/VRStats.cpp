@@ -0,0 +1,78 @@
+#include "VRStats.h"
+
+#include "VRWindow.h"
+
+VRStats::VRStats(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    m_timer.setInterval(500);
+    connect(&m_timer, &QTimer::timeout, this, &VRStats::refresh);
+    connect(this, &QQuickItem::windowChanged, this, &VRStats::handleWindowChanged);
+}
+
+QVariantMap VRStats::phases() const
+{
+    QVariantMap result;
+    for (int phase = 0; phase < VRFrameStatistics::PhaseCount; ++phase)
+    {
+        const VRFrameStatistics::Percentiles &cpu = m_summary.Cpu[phase];
+        const VRFrameStatistics::Percentiles &gpu = m_summary.Gpu[phase];
+
+        QVariantMap timings;
+        timings.insert(QStringLiteral("cpuP50"), cpu.P50);
+        timings.insert(QStringLiteral("cpuP95"), cpu.P95);
+        timings.insert(QStringLiteral("cpuP99"), cpu.P99);
+        timings.insert(QStringLiteral("gpuP50"), gpu.P50);
+        timings.insert(QStringLiteral("gpuP95"), gpu.P95);
+        timings.insert(QStringLiteral("gpuP99"), gpu.P99);
+
+        result.insert(QString::fromLatin1(VRFrameStatistics::phaseName(VRFrameStatistics::Phase(phase))), timings);
+    }
+    return result;
+}
+
+void VRStats::setWindowSize(int newWindowSize)
+{
+    if (newWindowSize > 0 && m_windowSize != newWindowSize)
+    {
+        m_windowSize = newWindowSize;
+        if (m_vrWindow)
+        {
+            m_vrWindow->frameStatistics()->setWindowSize(m_windowSize);
+        }
+        emit windowSizeChanged(newWindowSize);
+    }
+}
+
+void VRStats::setUpdateInterval(int newUpdateInterval)
+{
+    if (m_timer.interval() != newUpdateInterval)
+    {
+        m_timer.setInterval(newUpdateInterval);
+        emit updateIntervalChanged(newUpdateInterval);
+    }
+}
+
+void VRStats::handleWindowChanged(QQuickWindow *win)
+{
+    m_vrWindow = qobject_cast<VRWindow *>(win);
+
+    if (m_vrWindow)
+    {
+        m_vrWindow->frameStatistics()->setWindowSize(m_windowSize);
+        m_timer.start();
+    }
+    else
+    {
+        m_timer.stop();
+    }
+}
+
+void VRStats::refresh()
+{
+    if (m_vrWindow)
+    {
+        m_summary = m_vrWindow->frameStatistics()->summarize();
+        emit statsChanged();
+    }
+}
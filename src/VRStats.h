@@ -0,0 +1,75 @@
+#ifndef VRSTATS_H
+#define VRSTATS_H
+
+#include <QQuickItem>
+#include <QTimer>
+#include <QVariantMap>
+
+#include "VRFrameStatistics.h"
+
+class VRWindow;
+
+// Rolling frame time percentiles of the VRWindow this item lives in. All
+// times are in milliseconds.
+class VRStats : public QQuickItem
+{
+    Q_OBJECT
+    Q_PROPERTY(int windowSize READ windowSize WRITE setWindowSize NOTIFY windowSizeChanged)
+    Q_PROPERTY(int updateInterval READ updateInterval WRITE setUpdateInterval NOTIFY updateIntervalChanged)
+    Q_PROPERTY(int sampleCount READ sampleCount NOTIFY statsChanged)
+    Q_PROPERTY(bool gpuTimingAvailable READ gpuTimingAvailable NOTIFY statsChanged)
+    Q_PROPERTY(qreal frameBudget READ frameBudget NOTIFY statsChanged)
+    Q_PROPERTY(qreal overBudgetRatio READ overBudgetRatio NOTIFY statsChanged)
+    Q_PROPERTY(qreal cpuP50 READ cpuP50 NOTIFY statsChanged)
+    Q_PROPERTY(qreal cpuP95 READ cpuP95 NOTIFY statsChanged)
+    Q_PROPERTY(qreal cpuP99 READ cpuP99 NOTIFY statsChanged)
+    Q_PROPERTY(qreal gpuP50 READ gpuP50 NOTIFY statsChanged)
+    Q_PROPERTY(qreal gpuP95 READ gpuP95 NOTIFY statsChanged)
+    Q_PROPERTY(qreal gpuP99 READ gpuP99 NOTIFY statsChanged)
+    Q_PROPERTY(QVariantMap phases READ phases NOTIFY statsChanged)
+    Q_PROPERTY(int drawCalls READ drawCalls NOTIFY statsChanged)
+    Q_PROPERTY(int glCalls READ glCalls NOTIFY statsChanged)
+    Q_PROPERTY(int culledModels READ culledModels NOTIFY statsChanged)
+    Q_PROPERTY(qreal shadedSamples READ shadedSamples NOTIFY statsChanged)
+
+public:
+    explicit VRStats(QQuickItem *parent = nullptr);
+
+    int windowSize() const { return m_windowSize; }
+    int updateInterval() const { return m_timer.interval(); }
+    int sampleCount() const { return m_summary.SampleCount; }
+    bool gpuTimingAvailable() const { return m_summary.GpuSampleCount > 0; }
+    qreal frameBudget() const { return m_summary.FrameBudget; }
+    qreal overBudgetRatio() const { return m_summary.OverBudgetRatio; }
+    qreal cpuP50() const { return m_summary.Cpu[VRFrameStatistics::Frame].P50; }
+    qreal cpuP95() const { return m_summary.Cpu[VRFrameStatistics::Frame].P95; }
+    qreal cpuP99() const { return m_summary.Cpu[VRFrameStatistics::Frame].P99; }
+    qreal gpuP50() const { return m_summary.Gpu[VRFrameStatistics::Frame].P50; }
+    qreal gpuP95() const { return m_summary.Gpu[VRFrameStatistics::Frame].P95; }
+    qreal gpuP99() const { return m_summary.Gpu[VRFrameStatistics::Frame].P99; }
+    QVariantMap phases() const;
+    int drawCalls() const { return m_summary.Calls.DrawCalls; }
+    int glCalls() const { return m_summary.Calls.total(); }
+    int culledModels() const { return m_summary.Calls.Culled; }
+    qreal shadedSamples() const { return m_summary.ShadedSamples; }
+
+    void setWindowSize(int newWindowSize);
+    void setUpdateInterval(int newUpdateInterval);
+
+signals:
+    void windowSizeChanged(int);
+    void updateIntervalChanged(int);
+    void statsChanged();
+
+private slots:
+    void handleWindowChanged(QQuickWindow *win);
+    void refresh();
+
+private:
+    VRWindow *m_vrWindow = nullptr;
+    int m_windowSize = 300;
+    QTimer m_timer;
+    VRFrameStatistics::Summary m_summary;
+};
+
+#endif // VRSTATS_H
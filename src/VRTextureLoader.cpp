@@ -0,0 +1,309 @@
+#include "VRTextureLoader.h"
+
+#include <QtCore/QFileInfo>
+#include <QtCore/QThread>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+
+#include <cstring>
+
+VRTextureLoader::VRTextureLoader(QOpenGLContext *shareContext, QOffscreenSurface *surface)
+    : m_surface(surface)
+    , m_renderThread(QThread::currentThread())
+{
+    initializeOpenGLFunctions();
+
+    // Leave a core to the render thread and one to the GUI thread.
+    m_decoders.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 2));
+    m_ktxFormats = VRKtxImage::supportedFormats(shareContext);
+
+    m_uploadContext = new QOpenGLContext;
+    m_uploadContext->setFormat(shareContext->format());
+    m_uploadContext->setShareContext(shareContext);
+
+    if (!m_surface || !m_surface->isValid() || !m_uploadContext->create())
+    {
+        qWarning("Failed to create the texture upload context, textures are uploaded on the render thread.");
+        delete m_uploadContext;
+        m_uploadContext = nullptr;
+        m_uploadOnRenderThread = true;
+        return;
+    }
+
+    m_uploadThread = QThread::create([this]() { uploadLoop(); });
+    m_uploadThread->setObjectName(QStringLiteral("QuickVR texture upload"));
+    m_uploadContext->moveToThread(m_uploadThread);
+    m_uploadThread->start();
+}
+
+VRTextureLoader::~VRTextureLoader()
+{
+    m_decoders.clear();
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stopping = true;
+        m_decoded.clear();
+        m_wake.wakeAll();
+    }
+    m_decoders.waitForDone();
+
+    if (m_uploadThread)
+    {
+        m_uploadThread->wait();
+        delete m_uploadThread;
+        m_uploadThread = nullptr;
+    }
+
+    // uploadLoop() handed it back to this thread.
+    delete m_uploadContext;
+    m_uploadContext = nullptr;
+
+    // Finished, but nobody took them.
+    for (const Uploaded &uploaded : qAsConst(m_uploaded))
+    {
+        if (uploaded.Fence)
+            glDeleteSync(uploaded.Fence);
+        if (uploaded.Tex.Id)
+            glDeleteTextures(1, &uploaded.Tex.Id);
+    }
+    m_uploaded.clear();
+
+    if (m_renderPbo)
+    {
+        glDeleteBuffers(1, &m_renderPbo);
+        m_renderPbo = 0;
+    }
+}
+
+int VRTextureLoader::load(const QString &fileName)
+{
+    if (VRKtxImage::isKtxFile(fileName))
+    {
+        const int request = m_nextRequest++;
+        m_decoders.start([this, request, fileName]() {
+            Decoded decoded;
+            decoded.Request = request;
+            decoded.Ktx = readKtx(fileName);
+            enqueue(decoded);
+        });
+        return request;
+    }
+
+    return load([fileName]() {
+        QImage image(fileName);
+        if (image.isNull())
+        {
+            qWarning("Failed to load texture %s", qPrintable(fileName));
+            return image;
+        }
+
+        // OpenGL starts with the bottom row.
+        return image.mirrored();
+    });
+}
+
+int VRTextureLoader::load(const Decoder &decoder)
+{
+    const int request = m_nextRequest++;
+
+    m_decoders.start([this, request, decoder]() {
+        Decoded decoded;
+        decoded.Request = request;
+        decoded.Image = decoder();
+        if (!decoded.Image.isNull())
+            decoded.Image = decoded.Image.convertToFormat(QImage::Format_RGBA8888);
+        enqueue(decoded);
+    });
+
+    return request;
+}
+
+void VRTextureLoader::enqueue(const Decoded &decoded)
+{
+    QMutexLocker lock(&m_mutex);
+    if (!m_stopping)
+    {
+        m_decoded.enqueue(decoded);
+        m_wake.wakeOne();
+    }
+}
+
+VRKtxImage VRTextureLoader::readKtx(const QString &fileName) const
+{
+    QString error;
+    VRKtxImage image = VRKtxImage::read(fileName, &error);
+    if (image.isNull())
+    {
+        qWarning("Failed to load texture %s: %s", qPrintable(fileName), qPrintable(error));
+        return image;
+    }
+
+    const GLenum format = image.InternalFormat;
+    if (m_ktxFormats.contains(format))
+        return image;
+
+    const QFileInfo info(fileName);
+    const QString fallback = info.path() + QLatin1Char('/') + info.completeBaseName() + QLatin1String(".etc2.") + info.suffix();
+    if (QFileInfo::exists(fallback))
+    {
+        image = VRKtxImage::read(fallback, &error);
+        if (!image.isNull() && m_ktxFormats.contains(image.InternalFormat))
+            return image;
+    }
+
+    qWarning("Failed to load texture %s: format 0x%x is not supported by this GPU", qPrintable(fileName), format);
+    return VRKtxImage();
+}
+
+void VRTextureLoader::takeFinished(QVector<Texture> &textures)
+{
+    QVector<Uploaded> uploaded;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_uploadOnRenderThread && !m_decoded.isEmpty())
+            m_uploaded.append(upload(this, m_decoded.dequeue(), &m_renderPbo));
+        uploaded.swap(m_uploaded);
+    }
+
+    QVector<Uploaded> pending;
+    for (const Uploaded &u : qAsConst(uploaded))
+    {
+        if (u.Fence)
+        {
+            const GLenum status = glClientWaitSync(u.Fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            {
+                pending.append(u);
+                continue;
+            }
+            glDeleteSync(u.Fence);
+        }
+        textures.append(u.Tex);
+    }
+
+    if (!pending.isEmpty())
+    {
+        QMutexLocker lock(&m_mutex);
+        m_uploaded = pending + m_uploaded;
+    }
+}
+
+void VRTextureLoader::uploadLoop()
+{
+    QMutexLocker lock(&m_mutex);
+
+    if (!m_uploadContext->makeCurrent(m_surface))
+    {
+        qWarning("Failed to make the texture upload context current, textures are uploaded on the render thread.");
+        m_uploadOnRenderThread = true;
+        m_uploadContext->moveToThread(m_renderThread);
+        return;
+    }
+
+    QOpenGLExtraFunctions *gl = m_uploadContext->extraFunctions();
+    GLuint pbo = 0;
+
+    while (!m_stopping)
+    {
+        if (m_decoded.isEmpty())
+        {
+            m_wake.wait(&m_mutex);
+            continue;
+        }
+
+        const Decoded decoded = m_decoded.dequeue();
+        lock.unlock();
+        const Uploaded uploaded = upload(gl, decoded, &pbo);
+        lock.relock();
+
+        m_uploaded.append(uploaded);
+    }
+
+    if (pbo)
+        gl->glDeleteBuffers(1, &pbo);
+
+    m_uploadContext->doneCurrent();
+    m_uploadContext->moveToThread(m_renderThread);
+}
+
+VRTextureLoader::Uploaded VRTextureLoader::upload(QOpenGLExtraFunctions *gl, const Decoded &decoded, GLuint *pbo)
+{
+    Uploaded uploaded;
+    uploaded.Tex.Request = decoded.Request;
+    uploaded.Fence = 0;
+
+    const QImage &image = decoded.Image;
+    const VRKtxImage &ktx = decoded.Ktx;
+    if (image.isNull() && ktx.isNull())
+        return uploaded;
+
+    const uchar *source = ktx.isNull() ? image.constBits() : reinterpret_cast<const uchar *>(ktx.Data.constData());
+    const GLsizeiptr bytes = ktx.isNull() ? GLsizeiptr(image.sizeInBytes()) : GLsizeiptr(ktx.Data.size());
+
+    if (!*pbo)
+        gl->glGenBuffers(1, pbo);
+    gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, *pbo);
+
+    // Orphan the previous upload, the GPU may still be reading from it.
+    gl->glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+    const uchar *pixels = nullptr;
+    if (void *mapped = gl->glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT))
+    {
+        memcpy(mapped, source, size_t(bytes));
+        gl->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    else
+    {
+        gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        pixels = source;
+    }
+
+    gl->glGenTextures(1, &uploaded.Tex.Id);
+    gl->glBindTexture(GL_TEXTURE_2D, uploaded.Tex.Id);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    gl->glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    if (ktx.isNull())
+    {
+        gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, image.width(), image.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        gl->glGenerateMipmap(GL_TEXTURE_2D);
+        uploaded.Tex.Size = image.size();
+    }
+    else
+    {
+        // Files may stop short of a full chain, sample only what is there.
+        gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, ktx.Levels.size() - 1);
+
+        for (int level = 0; level < ktx.Levels.size(); ++level)
+        {
+            const VRKtxImage::Level &l = ktx.Levels[level];
+            const void *data = pixels ? static_cast<const void *>(pixels + l.Offset) : reinterpret_cast<const void *>(quintptr(l.Offset));
+            if (ktx.Compressed)
+                gl->glCompressedTexImage2D(GL_TEXTURE_2D, level, ktx.InternalFormat, l.Size.width(), l.Size.height(), 0, GLsizei(l.Length), data);
+            else
+                gl->glTexImage2D(GL_TEXTURE_2D, level, ktx.InternalFormat, l.Size.width(), l.Size.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        }
+
+        // Uncompressed files without mipmaps get them generated, compressed
+        // ones are sampled without.
+        if (ktx.Levels.size() == 1 && !ktx.Compressed)
+        {
+            gl->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+            gl->glGenerateMipmap(GL_TEXTURE_2D);
+        }
+        uploaded.Tex.Size = ktx.Levels.first().Size;
+    }
+
+    gl->glBindTexture(GL_TEXTURE_2D, 0);
+    gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // The flush gets the fence to the GPU, the render thread would otherwise
+    // poll it forever.
+    uploaded.Fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    gl->glFlush();
+
+    return uploaded;
+}
@@ -0,0 +1,98 @@
+#ifndef VRTEXTURELOADER_H
+#define VRTEXTURELOADER_H
+
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QSize>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
+#include <QtGui/QImage>
+#include <QtGui/QOpenGLExtraFunctions>
+
+#include <functional>
+
+#include "VRKtxImage.h"
+
+class QOffscreenSurface;
+class QOpenGLContext;
+class QThread;
+
+// Loads textures without stalling the render thread. Images are decoded on
+// a thread pool and uploaded through a pixel buffer object by a thread of
+// its own, on an OpenGL context shared with the render context. Each upload
+// is fenced; takeFinished() only hands out textures whose fence signaled,
+// so the render thread never waits for the copy.
+//
+// KTX and KTX 2 files are uploaded as stored, compressed and with their own
+// mip chain. When the GPU can't sample a file's format, name.etc2.ktx2 next
+// to name.ktx2 is tried instead, so BCn texture sets can ship an ETC2
+// variant for mobile GPUs.
+//
+// Created, polled and destroyed on the render thread with its context
+// current. The surface must have been created on the GUI thread.
+class VRTextureLoader : protected QOpenGLExtraFunctions
+{
+public:
+    struct Texture
+    {
+        int    Request = 0;
+        GLuint Id = 0;      // mipmapped, 0 when decoding failed
+        QSize  Size;
+    };
+
+    // Runs on a worker thread.
+    typedef std::function<QImage()> Decoder;
+
+    VRTextureLoader(QOpenGLContext *shareContext, QOffscreenSurface *surface);
+    ~VRTextureLoader();
+
+    // Both return a request id matched by Texture::Request. Images other
+    // than KTX are uploaded as GL_SRGB8_ALPHA8.
+    int load(const QString &fileName);
+    int load(const Decoder &decoder);
+
+    // Appends the textures that are ready to be sampled, their ownership
+    // moves to the caller.
+    void takeFinished(QVector<Texture> &textures);
+
+private:
+    struct Decoded
+    {
+        int        Request;
+        QImage     Image;   // Format_RGBA8888, bottom row first
+        VRKtxImage Ktx;     // used instead of Image when not null, bottom row first too
+    };
+
+    struct Uploaded
+    {
+        Texture Tex;
+        GLsync  Fence;
+    };
+
+    void enqueue(const Decoded &decoded);
+    VRKtxImage readKtx(const QString &fileName) const;
+    void uploadLoop();
+    static Uploaded upload(QOpenGLExtraFunctions *gl, const Decoded &decoded, GLuint *pbo);
+
+    QOpenGLContext *m_uploadContext = nullptr;
+    QOffscreenSurface *m_surface;
+    QThread *m_uploadThread = nullptr;
+    QThread *m_renderThread;
+    QThreadPool m_decoders;
+    QVector<GLenum> m_ktxFormats;   // read by the decoders, constant
+    int m_nextRequest = 1;
+
+    // Used when no shared context could be made: one image is uploaded per
+    // takeFinished() on the render thread instead.
+    bool m_uploadOnRenderThread = false;
+    GLuint m_renderPbo = 0;
+
+    QMutex m_mutex;
+    QWaitCondition m_wake;
+    bool m_stopping = false;
+    QQueue<Decoded> m_decoded;
+    QVector<Uploaded> m_uploaded;
+};
+
+#endif // VRTEXTURELOADER_H
@@ -0,0 +1,180 @@
+#include "VRTransformHierarchy.h"
+#include "VRSimd.h"
+
+#include <algorithm>
+#include <numeric>
+
+template <typename T>
+static void permute(std::vector<T> &values, const std::vector<int> &order)
+{
+    std::vector<T> sorted(values.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        sorted[i] = values[order[i]];
+    values.swap(sorted);
+}
+
+void VRTransformHierarchy::set(quint64 id, quint64 parentId, const QMatrix4x4 &local)
+{
+    const auto it = m_index.constFind(id);
+    if (it == m_index.constEnd())
+    {
+        m_index.insert(id, int(m_ids.size()));
+        m_ids.push_back(id);
+        m_parentIds.push_back(parentId);
+        m_parents.push_back(-1);
+        m_local.push_back(local);
+        m_world.push_back(QMatrix4x4());
+        m_dirty.push_back(1);
+        m_unsorted = true;
+        return;
+    }
+
+    const int index = it.value();
+    if (m_parentIds[index] != parentId)
+    {
+        m_parentIds[index] = parentId;
+        m_unsorted = true;
+    }
+    if (m_local[index] != local)
+    {
+        m_local[index] = local;
+        m_dirty[index] = 1;
+        m_firstDirty = qMin(m_firstDirty, index);
+    }
+}
+
+void VRTransformHierarchy::remove(quint64 id)
+{
+    const int index = m_index.value(id, -1);
+    if (index < 0)
+        return;
+    m_index.remove(id);
+
+    // Order is restored by the next update().
+    const int last = int(m_ids.size()) - 1;
+    if (index != last)
+    {
+        m_ids[index] = m_ids[last];
+        m_parentIds[index] = m_parentIds[last];
+        m_local[index] = m_local[last];
+        m_world[index] = m_world[last];
+        m_dirty[index] = m_dirty[last];
+        m_index[m_ids[index]] = index;
+    }
+    m_ids.pop_back();
+    m_parentIds.pop_back();
+    m_parents.pop_back();
+    m_local.pop_back();
+    m_world.pop_back();
+    m_dirty.pop_back();
+    m_unsorted = true;
+}
+
+void VRTransformHierarchy::clear()
+{
+    m_ids.clear();
+    m_parentIds.clear();
+    m_parents.clear();
+    m_local.clear();
+    m_world.clear();
+    m_dirty.clear();
+    m_index.clear();
+    m_firstDirty = INT_MAX;
+    m_unsorted = false;
+}
+
+QMatrix4x4 VRTransformHierarchy::world(quint64 id) const
+{
+    const int index = m_index.value(id, -1);
+    return index >= 0 ? m_world[index] : QMatrix4x4();
+}
+
+// Resolves parent ids and orders the nodes by depth. Only needed after
+// nodes were added, removed or reparented, and every node is recomputed
+// afterwards; update() still only reports the ones that actually moved.
+void VRTransformHierarchy::sort()
+{
+    const int count = int(m_ids.size());
+
+    for (int i = 0; i < count; ++i)
+        m_parents[i] = m_parentIds[i] != m_ids[i] ? m_index.value(m_parentIds[i], -1) : -1;
+
+    // Items form a tree, but ids of stale parents may still close a loop
+    // for a frame. Walks longer than the node count are cut at the start.
+    std::vector<int> depth(count, 0);
+    for (int i = 0; i < count; ++i)
+    {
+        int d = 0;
+        for (int p = m_parents[i]; p >= 0 && d <= count; p = m_parents[p])
+            ++d;
+        if (d > count)
+            m_parents[i] = -1;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        for (int p = m_parents[i]; p >= 0; p = m_parents[p])
+            ++depth[i];
+    }
+
+    std::vector<int> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&depth](int a, int b) { return depth[a] < depth[b]; });
+
+    std::vector<int> newIndex(count);
+    for (int i = 0; i < count; ++i)
+        newIndex[order[i]] = i;
+
+    permute(m_ids, order);
+    permute(m_parentIds, order);
+    permute(m_parents, order);
+    permute(m_local, order);
+    permute(m_world, order);
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (m_parents[i] >= 0)
+            m_parents[i] = newIndex[m_parents[i]];
+        m_index[m_ids[i]] = i;
+    }
+
+    std::fill(m_dirty.begin(), m_dirty.end(), 1);
+    m_firstDirty = 0;
+    m_unsorted = false;
+}
+
+void VRTransformHierarchy::update(QVector<quint64> &changed)
+{
+    if (m_unsorted)
+        sort();
+
+    const int count = int(m_ids.size());
+    if (m_firstDirty >= count)
+    {
+        m_firstDirty = INT_MAX;
+        return;
+    }
+
+    // Parents come first, so by the time a node is reached its parent's
+    // flag says whether the parent's world transform moved: 2 if it did.
+    for (int i = m_firstDirty; i < count; ++i)
+    {
+        const int parent = m_parents[i];
+        if (!m_dirty[i] && (parent < 0 || m_dirty[parent] != 2))
+            continue;
+
+        const QMatrix4x4 world = parent >= 0 ? VRSimd::multiply(m_world[parent], m_local[i]) : m_local[i];
+        if (world != m_world[i])
+        {
+            m_world[i] = world;
+            m_dirty[i] = 2;
+            changed.append(m_ids[i]);
+        }
+        else
+        {
+            m_dirty[i] = 0;
+        }
+    }
+
+    std::fill(m_dirty.begin() + m_firstDirty, m_dirty.end(), 0);
+    m_firstDirty = INT_MAX;
+}
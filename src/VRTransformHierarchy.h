@@ -0,0 +1,49 @@
+#ifndef VRTRANSFORMHIERARCHY_H
+#define VRTRANSFORMHIERARCHY_H
+
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+#include <QtGui/QMatrix4x4>
+
+#include <climits>
+#include <vector>
+
+// Local and world transforms of a tree of nodes, kept in parallel arrays
+// ordered so that every parent comes before its children. Setting a local
+// transform only flags the node; update() then makes one pass from the
+// first flagged node on and recomputes the world transforms of flagged
+// nodes and of the descendants of nodes whose world transform changed.
+// Nodes that never move cost nothing after the pass that placed them.
+//
+// Nodes are identified by the caller's ids. A parent id that isn't in the
+// hierarchy (yet) makes the node a root until that parent is added.
+class VRTransformHierarchy
+{
+public:
+    void set(quint64 id, quint64 parentId, const QMatrix4x4 &local);
+    void remove(quint64 id);
+    void clear();
+
+    // Appends the ids whose world transform changed since the last call.
+    void update(QVector<quint64> &changed);
+
+    // Identity for unknown ids. Current as of the last update().
+    QMatrix4x4 world(quint64 id) const;
+
+private:
+    void sort();
+
+    // Parallel arrays, parents before children after sort().
+    std::vector<quint64>    m_ids;
+    std::vector<quint64>    m_parentIds;
+    std::vector<int>        m_parents;      // index, -1 for roots
+    std::vector<QMatrix4x4> m_local;
+    std::vector<QMatrix4x4> m_world;
+    std::vector<quint8>     m_dirty;        // local changed, or world changed during update()
+
+    QHash<quint64, int> m_index;
+    int m_firstDirty = INT_MAX;
+    bool m_unsorted = false;
+};
+
+#endif // VRTRANSFORMHIERARCHY_H
@@ -1,14 +1,31 @@
 #include "VRWindow.h"
+#include "VRModel.h"
+#include "VRPanel.h"
 #include "VRRenderer.h"
 
 VRWindow::VRWindow(QWindow *parent)
     : QQuickView(parent)
 {
     connect(this, &QQuickWindow::beforeSynchronizing, this, &VRWindow::sync, Qt::DirectConnection);
+
+    // The renderer's texture upload thread draws on this. Offscreen surfaces
+    // may need a native window, which only the GUI thread can create.
+    m_textureSurface.setFormat(requestedFormat());
+    m_textureSurface.create();
 }
 
 VRWindow::~VRWindow()
 {
+    // The items outlive this part of the window, make sure they don't call back.
+    for (VRModel *model : qAsConst(m_models))
+    {
+        model->detachWindow();
+    }
+    for (VRPanel *panel : qAsConst(m_panels))
+    {
+        panel->detachWindow();
+    }
+
     if (m_renderer)
     {
         delete m_renderer;
@@ -16,12 +33,221 @@ VRWindow::~VRWindow()
     }
 }
 
+void VRWindow::setStereoMode(StereoMode newStereoMode)
+{
+    if (m_stereoMode != newStereoMode)
+    {
+        m_stereoMode = newStereoMode;
+        emit stereoModeChanged(newStereoMode);
+    }
+}
+
+void VRWindow::setFrustumCulling(bool newFrustumCulling)
+{
+    if (m_frustumCulling != newFrustumCulling)
+    {
+        m_frustumCulling = newFrustumCulling;
+        update();
+        emit frustumCullingChanged(newFrustumCulling);
+    }
+}
+
+void VRWindow::setLateLatching(bool newLateLatching)
+{
+    if (m_lateLatching != newLateLatching)
+    {
+        m_lateLatching = newLateLatching;
+        update();
+        emit lateLatchingChanged(newLateLatching);
+    }
+}
+
+void VRWindow::setMinResolutionScale(qreal newMinResolutionScale)
+{
+    if (m_minResolutionScale != newMinResolutionScale)
+    {
+        m_minResolutionScale = newMinResolutionScale;
+        update();
+        emit minResolutionScaleChanged(newMinResolutionScale);
+    }
+}
+
+void VRWindow::setMaxResolutionScale(qreal newMaxResolutionScale)
+{
+    if (m_maxResolutionScale != newMaxResolutionScale)
+    {
+        m_maxResolutionScale = newMaxResolutionScale;
+        update();
+        emit maxResolutionScaleChanged(newMaxResolutionScale);
+    }
+}
+
+void VRWindow::setFoveation(bool newFoveation)
+{
+    if (m_foveation != newFoveation)
+    {
+        m_foveation = newFoveation;
+        update();
+        emit foveationChanged(newFoveation);
+    }
+}
+
+void VRWindow::setFoveaRadius(qreal newFoveaRadius)
+{
+    if (m_foveaRadius != newFoveaRadius)
+    {
+        m_foveaRadius = newFoveaRadius;
+        update();
+        emit foveaRadiusChanged(newFoveaRadius);
+    }
+}
+
+void VRWindow::setFoveaFalloff(qreal newFoveaFalloff)
+{
+    if (m_foveaFalloff != newFoveaFalloff)
+    {
+        m_foveaFalloff = newFoveaFalloff;
+        update();
+        emit foveaFalloffChanged(newFoveaFalloff);
+    }
+}
+
+void VRWindow::setMirrorMode(MirrorMode newMirrorMode)
+{
+    if (m_mirrorMode != newMirrorMode)
+    {
+        m_mirrorMode = newMirrorMode;
+        update();
+        emit mirrorModeChanged(newMirrorMode);
+    }
+}
+
+void VRWindow::setMirrorScale(qreal newMirrorScale)
+{
+    if (m_mirrorScale != newMirrorScale)
+    {
+        m_mirrorScale = newMirrorScale;
+        update();
+        emit mirrorScaleChanged(newMirrorScale);
+    }
+}
+
+void VRWindow::setMirrorInterval(int newMirrorInterval)
+{
+    if (m_mirrorInterval != newMirrorInterval)
+    {
+        m_mirrorInterval = newMirrorInterval;
+        update();
+        emit mirrorIntervalChanged(newMirrorInterval);
+    }
+}
+
+void VRWindow::setMirrorInWindow(bool newMirrorInWindow)
+{
+    if (m_mirrorInWindow != newMirrorInWindow)
+    {
+        m_mirrorInWindow = newMirrorInWindow;
+        update();
+        emit mirrorInWindowChanged(newMirrorInWindow);
+    }
+}
+
+void VRWindow::addModel(VRModel *model)
+{
+    m_models.insert(model);
+    markModelDirty(model);
+}
+
+void VRWindow::removeModel(VRModel *model)
+{
+    if (m_models.remove(model))
+    {
+        m_dirtyModels.remove(model);
+        m_removedModels.append(model->modelId());
+        update();
+    }
+}
+
+void VRWindow::markModelDirty(VRModel *model)
+{
+    m_dirtyModels.insert(model);
+    update();
+}
+
+void VRWindow::addPanel(VRPanel *panel)
+{
+    m_panels.insert(panel);
+    update();
+}
+
+void VRWindow::removePanel(VRPanel *panel)
+{
+    if (m_panels.remove(panel))
+    {
+        update();
+    }
+}
+
 void VRWindow::sync()
 {
     if (!m_renderer) {
-        m_renderer = new VRRenderer(this);
+        m_renderer = new VRRenderer(this, &m_frameStatistics, &m_textureSurface);
         connect(this, &QQuickWindow::beforeRendering,           m_renderer, &VRRenderer::init,    Qt::DirectConnection);
         connect(this, &QQuickWindow::beforeRenderPassRecording, m_renderer, &VRRenderer::paint,   Qt::DirectConnection);
         connect(this, &QQuickWindow::sceneGraphInvalidated,     m_renderer, &VRRenderer::cleanup, Qt::DirectConnection);
     }
+
+    m_renderer->setSinglePassStereo(m_stereoMode == SinglePass);
+    m_renderer->setFrustumCulling(m_frustumCulling);
+    m_renderer->setLateLatching(m_lateLatching);
+    m_renderer->setResolutionScaleRange(float(m_minResolutionScale), float(m_maxResolutionScale));
+    m_renderer->setFoveation(m_foveation, float(m_foveaRadius), float(m_foveaFalloff));
+    m_renderer->setMirror(m_mirrorMode != NoMirror, m_mirrorMode == LeftEyeMirror, float(m_mirrorScale), m_mirrorInterval, m_mirrorInWindow);
+    m_renderer->updateMirror();
+
+    // The renderer's scale changes on the render thread, where this runs;
+    // the notification belongs on the GUI thread.
+    const qreal resolutionScale = m_renderer->resolutionScale();
+    if (m_resolutionScale != resolutionScale)
+    {
+        m_resolutionScale = resolutionScale;
+        QMetaObject::invokeMethod(this, [this, resolutionScale]() {
+            emit resolutionScaleChanged(resolutionScale);
+        }, Qt::QueuedConnection);
+    }
+
+    // Panels are few and their layer's texture provider can only be
+    // queried here, on the render thread, so they are all handed over.
+    QVector<VRPanelData> panels;
+    panels.reserve(m_panels.size());
+    for (VRPanel *panel : qAsConst(m_panels))
+    {
+        panels.append(panel->panelData());
+    }
+    m_renderer->setPanels(panels);
+
+    if (!m_removedModels.isEmpty() || !m_dirtyModels.isEmpty())
+    {
+        QVector<VRModelData> changes;
+        changes.reserve(m_removedModels.size() + m_dirtyModels.size());
+
+        // Removals first, so a model re-added to this window in the same
+        // frame ends up alive.
+        for (quint64 id : qAsConst(m_removedModels))
+        {
+            VRModelData data;
+            data.Id = id;
+            data.Removed = true;
+            changes.append(data);
+        }
+        for (VRModel *model : qAsConst(m_dirtyModels))
+        {
+            changes.append(model->takeChanges());
+        }
+
+        m_removedModels.clear();
+        m_dirtyModels.clear();
+
+        m_renderer->queueModelChanges(changes);
+    }
 }
@@ -1,26 +1,163 @@
 #ifndef VRWINDOW_H
 #define VRWINDOW_H
 
+#include <QOffscreenSurface>
 #include <QQuickView>
+#include <QSet>
+#include <QVector>
 #include <QVector3D>
 
+#include "VRFrameStatistics.h"
+
+class VRModel;
+class VRPanel;
 class VRRenderer;
 
 class VRWindow : public QQuickView
 {
     Q_OBJECT
     Q_DISABLE_COPY(VRWindow)
+    Q_PROPERTY(StereoMode stereoMode READ stereoMode WRITE setStereoMode NOTIFY stereoModeChanged)
+    Q_PROPERTY(bool frustumCulling READ frustumCulling WRITE setFrustumCulling NOTIFY frustumCullingChanged)
+    Q_PROPERTY(bool lateLatching READ lateLatching WRITE setLateLatching NOTIFY lateLatchingChanged)
+    Q_PROPERTY(qreal minResolutionScale READ minResolutionScale WRITE setMinResolutionScale NOTIFY minResolutionScaleChanged)
+    Q_PROPERTY(qreal maxResolutionScale READ maxResolutionScale WRITE setMaxResolutionScale NOTIFY maxResolutionScaleChanged)
+    Q_PROPERTY(qreal resolutionScale READ resolutionScale NOTIFY resolutionScaleChanged)
+    Q_PROPERTY(bool foveation READ foveation WRITE setFoveation NOTIFY foveationChanged)
+    Q_PROPERTY(qreal foveaRadius READ foveaRadius WRITE setFoveaRadius NOTIFY foveaRadiusChanged)
+    Q_PROPERTY(qreal foveaFalloff READ foveaFalloff WRITE setFoveaFalloff NOTIFY foveaFalloffChanged)
+    Q_PROPERTY(MirrorMode mirrorMode READ mirrorMode WRITE setMirrorMode NOTIFY mirrorModeChanged)
+    Q_PROPERTY(qreal mirrorScale READ mirrorScale WRITE setMirrorScale NOTIFY mirrorScaleChanged)
+    Q_PROPERTY(int mirrorInterval READ mirrorInterval WRITE setMirrorInterval NOTIFY mirrorIntervalChanged)
+    Q_PROPERTY(bool mirrorInWindow READ mirrorInWindow WRITE setMirrorInWindow NOTIFY mirrorInWindowChanged)
 
 public:
+    // SinglePass draws both eyes with one instanced draw per model and falls
+    // back to MultiPass when the shaders can't be built.
+    enum StereoMode
+    {
+        MultiPass,
+        SinglePass
+    };
+    Q_ENUM(StereoMode)
+
+    // What the desktop mirror shows. NoMirror doesn't ask the runtime for
+    // one, the cheapest, as nothing is composed or copied for the desktop.
+    enum MirrorMode
+    {
+        NoMirror,
+        LeftEyeMirror,
+        BothEyesMirror
+    };
+    Q_ENUM(MirrorMode)
+
     explicit VRWindow(QWindow *parent = nullptr);
     virtual ~VRWindow() override;
 
+    StereoMode stereoMode() const { return m_stereoMode; }
+    void setStereoMode(StereoMode newStereoMode);
+
+    // Skips models outside both eye frusta. Only worth turning off to
+    // measure what it saves.
+    bool frustumCulling() const { return m_frustumCulling; }
+    void setFrustumCulling(bool newFrustumCulling);
+
+    // Samples the head pose a second time after culling and the other CPU
+    // work of the frame, just before the eye buffers are drawn, and renders
+    // and submits with that one.
+    bool lateLatching() const { return m_lateLatching; }
+    void setLateLatching(bool newLateLatching);
+
+    // Eye buffers are drawn at a scale of the recommended size between
+    // these two, lowered when the GPU gets close to the refresh budget and
+    // raised again when it has headroom. Equal values fix the scale. The
+    // buffers are allocated at maxResolutionScale when the scene graph is
+    // initialized, raising it later only takes effect after that.
+    qreal minResolutionScale() const { return m_minResolutionScale; }
+    void setMinResolutionScale(qreal newMinResolutionScale);
+    qreal maxResolutionScale() const { return m_maxResolutionScale; }
+    void setMaxResolutionScale(qreal newMaxResolutionScale);
+    qreal resolutionScale() const { return m_resolutionScale; }
+
+    // Shades the periphery of the eye buffers at a lower rate: every pixel
+    // within foveaRadius of the center of each eye, half of them up to
+    // foveaRadius + foveaFalloff and a quarter beyond. Both are in units of
+    // half the eye buffer height.
+    bool foveation() const { return m_foveation; }
+    void setFoveation(bool newFoveation);
+    qreal foveaRadius() const { return m_foveaRadius; }
+    void setFoveaRadius(qreal newFoveaRadius);
+    qreal foveaFalloff() const { return m_foveaFalloff; }
+    void setFoveaFalloff(qreal newFoveaFalloff);
+
+    // The mirror is mirrorScale times the window size, in device pixels,
+    // and stretched to fill it; it is recreated once a resize is over.
+    // It is refreshed every mirrorInterval frames and drawn under the
+    // window's items when mirrorInWindow is set; a VRMirror item shows it
+    // anywhere in the scene instead.
+    MirrorMode mirrorMode() const { return m_mirrorMode; }
+    void setMirrorMode(MirrorMode newMirrorMode);
+    qreal mirrorScale() const { return m_mirrorScale; }
+    void setMirrorScale(qreal newMirrorScale);
+    int mirrorInterval() const { return m_mirrorInterval; }
+    void setMirrorInterval(int newMirrorInterval);
+    bool mirrorInWindow() const { return m_mirrorInWindow; }
+    void setMirrorInWindow(bool newMirrorInWindow);
+
     VRRenderer *renderer() const { return m_renderer; }
+    VRFrameStatistics *frameStatistics() { return &m_frameStatistics; }
+
+    // Called by VRModel on the GUI thread. Changes are collected and handed
+    // to the renderer by sync().
+    void addModel(VRModel *model);
+    void removeModel(VRModel *model);
+    void markModelDirty(VRModel *model);
+
+    // Called by VRPanel on the GUI thread. sync() hands every panel to the
+    // renderer each frame.
+    void addPanel(VRPanel *panel);
+    void removePanel(VRPanel *panel);
+
+signals:
+    void stereoModeChanged(StereoMode);
+    void frustumCullingChanged(bool);
+    void lateLatchingChanged(bool);
+    void minResolutionScaleChanged(qreal);
+    void maxResolutionScaleChanged(qreal);
+    void resolutionScaleChanged(qreal);
+    void foveationChanged(bool);
+    void foveaRadiusChanged(qreal);
+    void foveaFalloffChanged(qreal);
+    void mirrorModeChanged(MirrorMode);
+    void mirrorScaleChanged(qreal);
+    void mirrorIntervalChanged(int);
+    void mirrorInWindowChanged(bool);
+
 public slots:
     void sync();
 
 private:
     VRRenderer * m_renderer = nullptr;
+    VRFrameStatistics m_frameStatistics;
+    QOffscreenSurface m_textureSurface;
+    StereoMode m_stereoMode = SinglePass;
+    bool m_frustumCulling = true;
+    bool m_lateLatching = true;
+    qreal m_minResolutionScale = 0.5;
+    qreal m_maxResolutionScale = 1.0;
+    qreal m_resolutionScale = 1.0;
+    bool m_foveation = false;
+    qreal m_foveaRadius = 0.5;
+    qreal m_foveaFalloff = 0.3;
+    MirrorMode m_mirrorMode = BothEyesMirror;
+    qreal m_mirrorScale = 1.0;
+    int m_mirrorInterval = 1;
+    bool m_mirrorInWindow = true;
+
+    QSet<VRModel *> m_models;
+    QSet<VRModel *> m_dirtyModels;
+    QVector<quint64> m_removedModels;
+    QSet<VRPanel *> m_panels;
 };
 
 #endif // VRWINDOW_H
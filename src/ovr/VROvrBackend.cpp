@@ -0,0 +1,407 @@
+#include "VROvrBackend.h"
+
+#include <QtCore/QVarLengthArray>
+
+#pragma comment(lib, "user32.lib")
+
+#if defined(_WIN32)
+#include <dxgi.h> // for GetDefaultAdapterLuid
+#pragma comment(lib, "dxgi.lib")
+#endif
+
+#ifndef VALIDATE
+#define VALIDATE(x, msg) if (!(x)) { MessageBoxA(nullptr, (msg), "QuickVR", MB_ICONERROR | MB_OK); exit(-1); }
+#endif
+
+struct OculusTextureBuffer : public VRSwapChain, protected QOpenGLExtraFunctions
+{
+    ovrSession          Session;
+    ovrTextureSwapChain ColorTextureChain;
+    ovrTextureSwapChain DepthTextureChain;
+    OVR::Sizei          texSize;
+
+    OculusTextureBuffer(ovrSession session, OVR::Sizei size, int sampleCount, bool withDepth) :
+        Session(session),
+        ColorTextureChain(nullptr),
+        DepthTextureChain(nullptr),
+        texSize(0, 0)
+    {
+        assert(sampleCount <= 1); // The code doesn't currently handle MSAA textures.
+
+        texSize = size;
+
+        // This texture isn't necessarily going to be a rendertarget, but it usually is.
+        assert(session); // No HMD? A little odd.
+
+        initializeOpenGLFunctions();
+
+        ovrTextureSwapChainDesc desc = {};
+        desc.Type = ovrTexture_2D;
+        desc.ArraySize = 1;
+        desc.Width = size.w;
+        desc.Height = size.h;
+        desc.MipLevels = 1;
+        desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
+        desc.SampleCount = sampleCount;
+        desc.StaticImage = ovrFalse;
+
+        {
+            ovrResult result = ovr_CreateTextureSwapChainGL(Session, &desc, &ColorTextureChain);
+
+            int length = 0;
+            ovr_GetTextureSwapChainLength(session, ColorTextureChain, &length);
+
+            if(OVR_SUCCESS(result))
+            {
+                for (int i = 0; i < length; ++i)
+                {
+                    GLuint chainTexId;
+                    ovr_GetTextureSwapChainBufferGL(Session, ColorTextureChain, i, &chainTexId);
+                    glBindTexture(GL_TEXTURE_2D, chainTexId);
+
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                }
+            }
+        }
+
+        desc.Format = OVR_FORMAT_D32_FLOAT;
+
+        if (withDepth)
+        {
+            ovrResult result = ovr_CreateTextureSwapChainGL(Session, &desc, &DepthTextureChain);
+
+            int length = 0;
+            ovr_GetTextureSwapChainLength(session, DepthTextureChain, &length);
+
+            if (OVR_SUCCESS(result))
+            {
+                for (int i = 0; i < length; ++i)
+                {
+                    GLuint chainTexId;
+                    ovr_GetTextureSwapChainBufferGL(Session, DepthTextureChain, i, &chainTexId);
+                    glBindTexture(GL_TEXTURE_2D, chainTexId);
+
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                }
+            }
+        }
+    }
+
+    ~OculusTextureBuffer() override
+    {
+        if (ColorTextureChain)
+        {
+            ovr_DestroyTextureSwapChain(Session, ColorTextureChain);
+            ColorTextureChain = nullptr;
+        }
+        if (DepthTextureChain)
+        {
+            ovr_DestroyTextureSwapChain(Session, DepthTextureChain);
+            DepthTextureChain = nullptr;
+        }
+    }
+
+    QSize size() const override
+    {
+        return QSize(texSize.w, texSize.h);
+    }
+
+    bool isValid() const override
+    {
+        return ColorTextureChain != nullptr;
+    }
+
+    GLuint currentColorTexture() override
+    {
+        int curIndex;
+        GLuint curTexId;
+        ovr_GetTextureSwapChainCurrentIndex(Session, ColorTextureChain, &curIndex);
+        ovr_GetTextureSwapChainBufferGL(Session, ColorTextureChain, curIndex, &curTexId);
+        return curTexId;
+    }
+
+    GLuint currentDepthTexture() override
+    {
+        if (!DepthTextureChain)
+            return 0;
+
+        int curIndex;
+        GLuint curTexId;
+        ovr_GetTextureSwapChainCurrentIndex(Session, DepthTextureChain, &curIndex);
+        ovr_GetTextureSwapChainBufferGL(Session, DepthTextureChain, curIndex, &curTexId);
+        return curTexId;
+    }
+
+    void commit() override
+    {
+        ovr_CommitTextureSwapChain(Session, ColorTextureChain);
+        if (DepthTextureChain)
+            ovr_CommitTextureSwapChain(Session, DepthTextureChain);
+    }
+};
+
+static ovrGraphicsLuid GetDefaultAdapterLuid()
+{
+    ovrGraphicsLuid luid = ovrGraphicsLuid();
+
+#if defined(_WIN32)
+    IDXGIFactory* factory = nullptr;
+
+    if (SUCCEEDED(CreateDXGIFactory(IID_PPV_ARGS(&factory))))
+    {
+        IDXGIAdapter* adapter = nullptr;
+
+        if (SUCCEEDED(factory->EnumAdapters(0, &adapter)))
+        {
+            DXGI_ADAPTER_DESC desc;
+
+            adapter->GetDesc(&desc);
+            memcpy(&luid, &desc.AdapterLuid, sizeof(luid));
+            adapter->Release();
+        }
+
+        factory->Release();
+    }
+#endif
+
+    return luid;
+}
+
+
+static int Compare(const ovrGraphicsLuid& lhs, const ovrGraphicsLuid& rhs)
+{
+    return memcmp(&lhs, &rhs, sizeof(ovrGraphicsLuid));
+}
+
+static ovrPosef ToOvrPose(const VRPose &pose)
+{
+    ovrPosef result;
+    result.Orientation.x = pose.Orientation.x();
+    result.Orientation.y = pose.Orientation.y();
+    result.Orientation.z = pose.Orientation.z();
+    result.Orientation.w = pose.Orientation.scalar();
+    result.Position.x = pose.Position.x();
+    result.Position.y = pose.Position.y();
+    result.Position.z = pose.Position.z();
+    return result;
+}
+
+static VRPose FromOvrPose(const ovrPosef &pose)
+{
+    VRPose result;
+    result.Orientation = QQuaternion(pose.Orientation.w, pose.Orientation.x, pose.Orientation.y, pose.Orientation.z);
+    result.Position = QVector3D(pose.Position.x, pose.Position.y, pose.Position.z);
+    return result;
+}
+
+VROvrBackend::VROvrBackend()
+{
+}
+
+VROvrBackend::~VROvrBackend()
+{
+    destroySession();
+
+    if (initialized)
+    {
+        ovr_Shutdown();
+        initialized = false;
+    }
+}
+
+bool VROvrBackend::initialize()
+{
+    // Initializes LibOVR, and the Rift
+    ovrInitParams initParams = { ovrInit_RequestVersion | ovrInit_FocusAware, OVR_MINOR_VERSION, NULL, 0, 0 };
+
+    ovrResult result = ovr_Initialize(&initParams);
+    initialized = OVR_SUCCESS(result);
+    return initialized;
+}
+
+bool VROvrBackend::createSession()
+{
+    if (session)
+    {
+        return true;
+    }
+
+    ovrResult result = ovr_Create(&session, &luid);
+    if (!OVR_SUCCESS(result))
+        return false;
+
+    initializeOpenGLFunctions();
+
+    if (Compare(luid, GetDefaultAdapterLuid())) // If luid that the Rift is on is not the default adapter LUID...
+    {
+        VALIDATE(false, "OpenGL supports only the default graphics adapter.");
+    }
+
+    hmdDesc = ovr_GetHmdDesc(session);
+    qDebug("ProductName\t = %s", hmdDesc.ProductName);
+    qDebug("Manufacturer\t = %s", hmdDesc.Manufacturer);
+    qDebug("SerialNumber\t = %s", hmdDesc.SerialNumber);
+
+    // FloorLevel will give tracking poses where the floor height is 0
+    ovr_SetTrackingOriginType(session, ovrTrackingOrigin_FloorLevel);
+
+    return true;
+}
+
+void VROvrBackend::destroySession()
+{
+    destroyMirrorTexture();
+
+    if (session)
+    {
+        ovr_Destroy(session);
+        session = nullptr;
+    }
+}
+
+QSize VROvrBackend::recommendedTextureSize(int eye) const
+{
+    ovrSizei idealTextureSize = ovr_GetFovTextureSize(session, ovrEyeType(eye), hmdDesc.DefaultEyeFov[eye], 1);
+    return QSize(idealTextureSize.w, idealTextureSize.h);
+}
+
+QMatrix4x4 VROvrBackend::projection(int eye, float zNear, float zFar) const
+{
+    // OVR matrices are row-major, which is what QMatrix4x4's array constructor expects.
+    OVR::Matrix4f proj = ovrMatrix4f_Projection(hmdDesc.DefaultEyeFov[eye], zNear, zFar, ovrProjection_None);
+    return QMatrix4x4(&proj.M[0][0]);
+}
+
+VRSessionStatus VROvrBackend::sessionStatus()
+{
+    ovrSessionStatus ovrStatus;
+    ovr_GetSessionStatus(session, &ovrStatus);
+
+    VRSessionStatus status;
+    status.IsVisible = ovrStatus.IsVisible;
+    status.HasInputFocus = ovrStatus.HasInputFocus;
+    status.ShouldQuit = ovrStatus.ShouldQuit;
+    status.ShouldRecenter = ovrStatus.ShouldRecenter;
+    return status;
+}
+
+void VROvrBackend::recenter()
+{
+    ovr_RecenterTrackingOrigin(session);
+}
+
+double VROvrBackend::predictedDisplayTime(long long frameIndex) const
+{
+    return ovr_GetPredictedDisplayTime(session, frameIndex);
+}
+
+void VROvrBackend::getEyePoses(long long frameIndex, VRPose eyePoses[2], double *sensorSampleTime)
+{
+    // Call ovr_GetRenderDesc each frame to get the ovrEyeRenderDesc, as the returned values (e.g. HmdToEyePose) may change at runtime.
+    ovrEyeRenderDesc eyeRenderDesc[2];
+    eyeRenderDesc[0] = ovr_GetRenderDesc(session, ovrEye_Left, hmdDesc.DefaultEyeFov[0]);
+    eyeRenderDesc[1] = ovr_GetRenderDesc(session, ovrEye_Right, hmdDesc.DefaultEyeFov[1]);
+
+    // Get eye poses, feeding in correct IPD offset
+    ovrPosef EyeRenderPose[2];
+    ovrPosef HmdToEyePose[2] = { eyeRenderDesc[0].HmdToEyePose,
+                                 eyeRenderDesc[1].HmdToEyePose};
+
+    ovr_GetEyePoses(session, frameIndex, ovrTrue, HmdToEyePose, EyeRenderPose, sensorSampleTime);
+
+    for (int eye = 0; eye < 2; ++eye)
+    {
+        eyePoses[eye] = FromOvrPose(EyeRenderPose[eye]);
+    }
+}
+
+VRSwapChain *VROvrBackend::createSwapChain(const QSize &size, bool withDepth)
+{
+    return new OculusTextureBuffer(session, OVR::Sizei(size.width(), size.height()), 1, withDepth);
+}
+
+bool VROvrBackend::submitFrame(long long frameIndex, const VREyeLayer &layer, const QVector<VRQuadLayer> &quads)
+{
+    ovrLayerEyeFovDepth ld = {};
+    ld.Header.Type  = ovrLayerType_EyeFovDepth;
+    ld.Header.Flags = ovrLayerFlag_TextureOriginAtBottomLeft;   // Because OpenGL.
+    ld.SensorSampleTime = layer.SensorSampleTime;
+
+    for (int eye = 0; eye < 2; ++eye)
+    {
+        OculusTextureBuffer *swapChain = static_cast<OculusTextureBuffer *>(layer.SwapChain[eye]);
+        const QRect &viewport = layer.Viewport[eye];
+
+        ld.ColorTexture[eye] = swapChain->ColorTextureChain;
+        ld.DepthTexture[eye] = swapChain->DepthTextureChain;
+        ld.Viewport[eye]     = OVR::Recti(viewport.x(), viewport.y(), viewport.width(), viewport.height());
+        ld.Fov[eye]          = hmdDesc.DefaultEyeFov[eye];
+        ld.RenderPose[eye]   = ToOvrPose(layer.RenderPose[eye]);
+    }
+
+    OVR::Matrix4f proj = ovrMatrix4f_Projection(hmdDesc.DefaultEyeFov[0], layer.ZNear, layer.ZFar, ovrProjection_None);
+    ld.ProjectionDesc = ovrTimewarpProjectionDesc_FromProjection(proj, ovrProjection_None);
+
+    QVarLengthArray<ovrLayerQuad, 4> quadLayers(quads.size());
+    QVarLengthArray<ovrLayerHeader *, 5> layers;
+    layers.append(&ld.Header);
+
+    for (int i = 0; i < quads.size(); ++i)
+    {
+        const VRQuadLayer &quad = quads[i];
+        OculusTextureBuffer *swapChain = static_cast<OculusTextureBuffer *>(quad.SwapChain);
+        const QRect &viewport = quad.Viewport;
+
+        ovrLayerQuad &lq = quadLayers[i];
+        memset(&lq, 0, sizeof(lq));
+        lq.Header.Type  = ovrLayerType_Quad;
+        lq.Header.Flags = ovrLayerFlag_TextureOriginAtBottomLeft | ovrLayerFlag_HighQuality;
+        if (quad.HeadLocked)
+            lq.Header.Flags |= ovrLayerFlag_HeadLocked;
+        lq.ColorTexture   = swapChain->ColorTextureChain;
+        lq.Viewport       = OVR::Recti(viewport.x(), viewport.y(), viewport.width(), viewport.height());
+        lq.QuadPoseCenter = ToOvrPose(quad.Pose);
+        lq.QuadSize       = OVR::Vector2f(float(quad.Size.width()), float(quad.Size.height()));
+        layers.append(&lq.Header);
+    }
+
+    ovrResult result = ovr_SubmitFrame(session, frameIndex, nullptr, layers.data(), layers.size());
+    return OVR_SUCCESS(result);
+}
+
+GLuint VROvrBackend::createMirrorTexture(const QSize &size, bool leftEyeOnly)
+{
+    destroyMirrorTexture();
+
+    ovrMirrorTextureDesc desc;
+    memset(&desc, 0, sizeof(desc));
+    desc.Width = size.width();
+    desc.Height = size.height();
+    desc.Format = OVR_FORMAT_R8G8B8A8_UNORM_SRGB;
+    desc.MirrorOptions = leftEyeOnly ? ovrMirrorOption_LeftEyeOnly : ovrMirrorOption_Default;
+
+    ovrResult result = ovr_CreateMirrorTextureWithOptionsGL(session, &desc, &mirrorTexture);
+    if (!OVR_SUCCESS(result))
+    {
+        return 0;
+    }
+
+    GLuint texId;
+    ovr_GetMirrorTextureBufferGL(session, mirrorTexture, &texId);
+    return texId;
+}
+
+void VROvrBackend::destroyMirrorTexture()
+{
+    if (mirrorTexture)
+    {
+        ovr_DestroyMirrorTexture(session, mirrorTexture);
+        mirrorTexture = nullptr;
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef VROVRBACKEND_H
+#define VROVRBACKEND_H
+
+#include "VRBackend.h"
+
+#include <QtGui/QOpenGLExtraFunctions>
+
+#include <OVR_CAPI_GL.h>
+#include <Extras/OVR_Math.h>
+
+class VROvrBackend : public VRBackend, protected QOpenGLExtraFunctions
+{
+public:
+    VROvrBackend();
+    ~VROvrBackend() override;
+
+    const char *name() const override { return "ovr"; }
+
+    bool initialize() override;
+    bool createSession() override;
+    void destroySession() override;
+
+    double refreshRate() const override { return hmdDesc.DisplayRefreshRate; }
+    QSize recommendedTextureSize(int eye) const override;
+    QMatrix4x4 projection(int eye, float zNear, float zFar) const override;
+
+    VRSessionStatus sessionStatus() override;
+    void recenter() override;
+    double predictedDisplayTime(long long frameIndex) const override;
+    void getEyePoses(long long frameIndex, VRPose eyePoses[2], double *sensorSampleTime) override;
+
+    VRSwapChain *createSwapChain(const QSize &size, bool withDepth) override;
+    bool submitFrame(long long frameIndex, const VREyeLayer &layer, const QVector<VRQuadLayer> &quads) override;
+
+    GLuint createMirrorTexture(const QSize &size, bool leftEyeOnly) override;
+    void destroyMirrorTexture() override;
+
+private:
+    bool initialized = false;
+    ovrSession session = nullptr;
+    ovrGraphicsLuid luid = {};
+    ovrHmdDesc hmdDesc = {};
+    ovrMirrorTexture mirrorTexture = nullptr;
+};
+
+#endif // VROVRBACKEND_H
@@ -0,0 +1,541 @@
+#include "VRSimBackend.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+#include <QtCore/QtMath>
+
+#include <algorithm>
+#include <cmath>
+
+// Field of view of a Rift CV1 class headset, as tangents of the half angles.
+static const float kUpTan       = 1.33f;
+static const float kDownTan     = 1.33f;
+static const float kNasalTan    = 1.06f;
+static const float kTemporalTan = 1.09f;
+
+static const int kSwapChainLength = 3;
+
+// A unit quad from the vertex index, drawn as a 4 vertex triangle strip.
+static const char *kQuadVertexShader =
+    "#version 150\n"
+    "uniform mat4 Transform;\n"
+    "out vec2 TexCoord;\n"
+    "void main()\n"
+    "{\n"
+    "    TexCoord = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "    gl_Position = Transform * vec4(TexCoord - 0.5, 0.0, 1.0);\n"
+    "}\n";
+
+static const char *kQuadFragmentShader =
+    "#version 150\n"
+    "uniform sampler2D Texture0;\n"
+    "in vec2 TexCoord;\n"
+    "out vec4 FragColor;\n"
+    "void main()\n"
+    "{\n"
+    "    FragColor = texture(Texture0, TexCoord);\n"
+    "}\n";
+
+struct SimTextureBuffer : public VRSwapChain, protected QOpenGLExtraFunctions
+{
+    GLuint  ColorTextures[kSwapChainLength];
+    GLuint  DepthTextures[kSwapChainLength];
+    int     CurrentIndex;
+    int     CommittedIndex;
+    QSize   texSize;
+
+    SimTextureBuffer(const QSize &size, bool withDepth) :
+        CurrentIndex(0),
+        CommittedIndex(-1),
+        texSize(size)
+    {
+        initializeOpenGLFunctions();
+
+        glGenTextures(kSwapChainLength, ColorTextures);
+        if (withDepth)
+            glGenTextures(kSwapChainLength, DepthTextures);
+        else
+            std::fill(DepthTextures, DepthTextures + kSwapChainLength, 0u);
+
+        for (int i = 0; i < kSwapChainLength; ++i)
+        {
+            glBindTexture(GL_TEXTURE_2D, ColorTextures[i]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, texSize.width(), texSize.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+            if (!DepthTextures[i])
+                continue;
+
+            glBindTexture(GL_TEXTURE_2D, DepthTextures[i]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, texSize.width(), texSize.height(), 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    ~SimTextureBuffer() override
+    {
+        glDeleteTextures(kSwapChainLength, ColorTextures);
+        glDeleteTextures(kSwapChainLength, DepthTextures);
+    }
+
+    QSize size() const override
+    {
+        return texSize;
+    }
+
+    bool isValid() const override
+    {
+        return ColorTextures[0] != 0;
+    }
+
+    GLuint currentColorTexture() override
+    {
+        return ColorTextures[CurrentIndex];
+    }
+
+    GLuint currentDepthTexture() override
+    {
+        return DepthTextures[CurrentIndex];
+    }
+
+    void commit() override
+    {
+        CommittedIndex = CurrentIndex;
+        CurrentIndex = (CurrentIndex + 1) % kSwapChainLength;
+    }
+
+    GLuint committedColorTexture() const
+    {
+        return CommittedIndex < 0 ? 0 : ColorTextures[CommittedIndex];
+    }
+};
+
+VRSimBackend::VRSimBackend()
+{
+}
+
+VRSimBackend::~VRSimBackend()
+{
+    destroySession();
+}
+
+bool VRSimBackend::initialize()
+{
+    bool ok = false;
+
+    const double refreshRate = qEnvironmentVariable("QUICKVR_SIM_REFRESH_RATE").toDouble(&ok);
+    if (ok && refreshRate > 0.0)
+    {
+        m_refreshRate = refreshRate;
+    }
+
+    const QStringList eyeSize = qEnvironmentVariable("QUICKVR_SIM_EYE_SIZE").split(QLatin1Char('x'));
+    if (eyeSize.size() == 2)
+    {
+        const QSize size(eyeSize[0].toInt(), eyeSize[1].toInt());
+        if (!size.isEmpty())
+        {
+            m_eyeSize = size;
+        }
+    }
+
+    const long long frameLimit = qEnvironmentVariable("QUICKVR_SIM_FRAMES").toLongLong(&ok);
+    if (ok && frameLimit > 0)
+    {
+        m_frameLimit = frameLimit;
+    }
+
+    const QString poseScript = qEnvironmentVariable("QUICKVR_SIM_POSES");
+    if (poseScript.isEmpty() || !loadPoseScript(poseScript))
+    {
+        buildDefaultPoseScript();
+    }
+
+    return true;
+}
+
+bool VRSimBackend::createSession()
+{
+    if (!m_session)
+    {
+        initializeOpenGLFunctions();
+
+        qDebug("ProductName\t = QuickVR Simulated HMD");
+        qDebug("Resolution\t = %dx%d per eye @ %.1f Hz", m_eyeSize.width(), m_eyeSize.height(), m_refreshRate);
+
+        m_framesSubmitted = 0;
+        m_session = true;
+    }
+
+    return true;
+}
+
+void VRSimBackend::destroySession()
+{
+    destroyMirrorTexture();
+    destroyQuadProgram();
+    m_session = false;
+}
+
+QSize VRSimBackend::recommendedTextureSize(int eye) const
+{
+    Q_UNUSED(eye);
+    return m_eyeSize;
+}
+
+QMatrix4x4 VRSimBackend::projection(int eye, float zNear, float zFar) const
+{
+    const float leftTan  = eye == 0 ? kTemporalTan : kNasalTan;
+    const float rightTan = eye == 0 ? kNasalTan : kTemporalTan;
+
+    QMatrix4x4 proj;
+    proj.frustum(-leftTan * zNear, rightTan * zNear, -kDownTan * zNear, kUpTan * zNear, zNear, zFar);
+    return proj;
+}
+
+VRSessionStatus VRSimBackend::sessionStatus()
+{
+    VRSessionStatus status;
+    status.IsVisible = m_session;
+    status.HasInputFocus = m_session;
+    status.ShouldQuit = m_frameLimit > 0 && m_framesSubmitted >= m_frameLimit;
+    return status;
+}
+
+void VRSimBackend::recenter()
+{
+    // The simulated tracking origin never drifts.
+}
+
+double VRSimBackend::predictedDisplayTime(long long frameIndex) const
+{
+    // Time is derived from the frame index rather than the wall clock so that
+    // every run replays the exact same head motion, however slow the GPU is.
+    return frameIndex / m_refreshRate;
+}
+
+void VRSimBackend::getEyePoses(long long frameIndex, VRPose eyePoses[2], double *sensorSampleTime)
+{
+    const double displayTime = predictedDisplayTime(frameIndex);
+    const VRPose head = headPoseAt(displayTime);
+
+    for (int eye = 0; eye < 2; ++eye)
+    {
+        const QVector3D eyeOffset((eye == 0 ? -0.5f : 0.5f) * m_ipd, 0.0f, 0.0f);
+        eyePoses[eye].Orientation = head.Orientation;
+        eyePoses[eye].Position = head.Position + head.Orientation.rotatedVector(eyeOffset);
+    }
+
+    if (sensorSampleTime)
+    {
+        *sensorSampleTime = displayTime;
+    }
+}
+
+VRSwapChain *VRSimBackend::createSwapChain(const QSize &size, bool withDepth)
+{
+    return new SimTextureBuffer(size, withDepth);
+}
+
+bool VRSimBackend::submitFrame(long long frameIndex, const VREyeLayer &layer, const QVector<VRQuadLayer> &quads)
+{
+    Q_UNUSED(frameIndex);
+
+    if (!m_session)
+    {
+        return false;
+    }
+
+    // Compose both eyes side by side into the mirror, the way the Oculus
+    // runtime's default mirror looks, or the left eye over its whole width.
+    if (m_mirrorTexture)
+    {
+        if (!m_readFBO)
+        {
+            glGenFramebuffers(1, &m_readFBO);
+        }
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_mirrorFBO);
+
+        const int eyeCount = m_mirrorLeftEyeOnly ? 1 : 2;
+        for (int eye = 0; eye < eyeCount; ++eye)
+        {
+            SimTextureBuffer *swapChain = static_cast<SimTextureBuffer *>(layer.SwapChain[eye]);
+            const QRect &src = layer.Viewport[eye];
+            const int dstX0 = eye * m_mirrorSize.width() / eyeCount;
+            const int dstX1 = (eye + 1) * m_mirrorSize.width() / eyeCount;
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, m_readFBO);
+            glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, swapChain->committedColorTexture(), 0);
+
+            // Flip vertically, the mirror is top-left origin like the Oculus one.
+            glBlitFramebuffer(src.left(), src.top(), src.left() + src.width(), src.top() + src.height(),
+                              dstX0, m_mirrorSize.height(), dstX1, 0,
+                              GL_COLOR_BUFFER_BIT, GL_LINEAR);
+        }
+
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+        if (!quads.isEmpty())
+        {
+            composeQuads(layer, quads, eyeCount);
+        }
+
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    }
+
+    ++m_framesSubmitted;
+    return true;
+}
+
+GLuint VRSimBackend::createMirrorTexture(const QSize &size, bool leftEyeOnly)
+{
+    destroyMirrorTexture();
+
+    m_mirrorSize = size;
+    m_mirrorLeftEyeOnly = leftEyeOnly;
+
+    glGenTextures(1, &m_mirrorTexture);
+    glBindTexture(GL_TEXTURE_2D, m_mirrorTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, size.width(), size.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &m_mirrorFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_mirrorFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_mirrorTexture, 0);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    return m_mirrorTexture;
+}
+
+// Draws the quads over the eyes in the mirror, which is bound as the draw
+// framebuffer, the way the compositor would draw them in the headset.
+void VRSimBackend::composeQuads(const VREyeLayer &layer, const QVector<VRQuadLayer> &quads, int eyeCount)
+{
+    if (!m_quadProgram && !createQuadProgram())
+    {
+        return;
+    }
+
+    glUseProgram(m_quadProgram);
+    glBindVertexArray(m_quadVertexArray);
+    glActiveTexture(GL_TEXTURE0);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_SCISSOR_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glEnable(GL_FRAMEBUFFER_SRGB);
+
+    // The mirror is top-left origin.
+    QMatrix4x4 flip;
+    flip.scale(1.0f, -1.0f, 1.0f);
+
+    for (int eye = 0; eye < eyeCount; ++eye)
+    {
+        const int x0 = eye * m_mirrorSize.width() / eyeCount;
+        const int x1 = (eye + 1) * m_mirrorSize.width() / eyeCount;
+        glViewport(x0, 0, x1 - x0, m_mirrorSize.height());
+
+        QMatrix4x4 eyePose;
+        eyePose.translate(layer.RenderPose[eye].Position);
+        eyePose.rotate(layer.RenderPose[eye].Orientation);
+        QMatrix4x4 eyeFromHead;
+        eyeFromHead.translate((eye == 0 ? 0.5f : -0.5f) * m_ipd, 0.0f, 0.0f);
+        const QMatrix4x4 viewProj = flip * projection(eye, layer.ZNear, layer.ZFar);
+
+        for (const VRQuadLayer &quad : quads)
+        {
+            QMatrix4x4 model;
+            model.translate(quad.Pose.Position);
+            model.rotate(quad.Pose.Orientation);
+            model.scale(float(quad.Size.width()), float(quad.Size.height()), 1.0f);
+
+            const QMatrix4x4 transform = viewProj * (quad.HeadLocked ? eyeFromHead : eyePose.inverted()) * model;
+            glUniformMatrix4fv(m_quadTransformLocation, 1, GL_FALSE, transform.constData());
+            glBindTexture(GL_TEXTURE_2D, static_cast<SimTextureBuffer *>(quad.SwapChain)->committedColorTexture());
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+    }
+
+    glDisable(GL_FRAMEBUFFER_SRGB);
+    glDisable(GL_BLEND);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+    glUseProgram(0);
+}
+
+bool VRSimBackend::createQuadProgram()
+{
+    const char *sources[2] = { kQuadVertexShader, kQuadFragmentShader };
+    const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+
+    m_quadProgram = glCreateProgram();
+    for (int i = 0; i < 2; ++i)
+    {
+        GLuint shader = glCreateShader(types[i]);
+        glShaderSource(shader, 1, &sources[i], nullptr);
+        glCompileShader(shader);
+        glAttachShader(m_quadProgram, shader);
+        glDeleteShader(shader);
+    }
+    glLinkProgram(m_quadProgram);
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(m_quadProgram, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        char log[512];
+        glGetProgramInfoLog(m_quadProgram, sizeof(log), nullptr, log);
+        qWarning("Cannot build the simulated compositor's quad shader: %s", log);
+        destroyQuadProgram();
+        return false;
+    }
+
+    glUseProgram(m_quadProgram);
+    glUniform1i(glGetUniformLocation(m_quadProgram, "Texture0"), 0);
+    glUseProgram(0);
+    m_quadTransformLocation = glGetUniformLocation(m_quadProgram, "Transform");
+
+    // Core profiles draw nothing without a vertex array, even an empty one.
+    glGenVertexArrays(1, &m_quadVertexArray);
+    return true;
+}
+
+void VRSimBackend::destroyQuadProgram()
+{
+    if (m_quadVertexArray)
+    {
+        glDeleteVertexArrays(1, &m_quadVertexArray);
+        m_quadVertexArray = 0;
+    }
+    if (m_quadProgram)
+    {
+        glDeleteProgram(m_quadProgram);
+        m_quadProgram = 0;
+    }
+}
+
+void VRSimBackend::destroyMirrorTexture()
+{
+    if (m_readFBO)
+    {
+        glDeleteFramebuffers(1, &m_readFBO);
+        m_readFBO = 0;
+    }
+    if (m_mirrorFBO)
+    {
+        glDeleteFramebuffers(1, &m_mirrorFBO);
+        m_mirrorFBO = 0;
+    }
+    if (m_mirrorTexture)
+    {
+        glDeleteTextures(1, &m_mirrorTexture);
+        m_mirrorTexture = 0;
+    }
+}
+
+bool VRSimBackend::loadPoseScript(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qWarning("Cannot open pose script %s, using the default one.", qPrintable(fileName));
+        return false;
+    }
+
+    QVector<Keyframe> script;
+    QTextStream stream(&file);
+    while (!stream.atEnd())
+    {
+        const QString line = stream.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#')))
+        {
+            continue;
+        }
+
+        const QStringList fields = line.split(QLatin1Char(' '), Qt::SkipEmptyParts);
+        if (fields.size() != 7)
+        {
+            qWarning("Ignoring malformed pose script line: %s", qPrintable(line));
+            continue;
+        }
+
+        Keyframe key;
+        key.Time = fields[0].toDouble();
+        key.Pose.Position = QVector3D(fields[1].toFloat(), fields[2].toFloat(), fields[3].toFloat());
+        key.Pose.Orientation = QQuaternion::fromEulerAngles(fields[5].toFloat(), fields[4].toFloat(), fields[6].toFloat());
+
+        if (!script.isEmpty() && key.Time <= script.last().Time)
+        {
+            qWarning("Pose script timestamps must increase: %s", qPrintable(line));
+            continue;
+        }
+        script.append(key);
+    }
+
+    if (script.isEmpty())
+    {
+        qWarning("Pose script %s has no keyframes, using the default one.", qPrintable(fileName));
+        return false;
+    }
+
+    m_poseScript = script;
+    return true;
+}
+
+void VRSimBackend::buildDefaultPoseScript()
+{
+    // A seated user looking around: slow yaw sweep with a bit of pitch and
+    // head bob, four seconds long.
+    m_poseScript.clear();
+    for (int i = 0; i <= 16; ++i)
+    {
+        const double t = i * 0.25;
+        const float phase = float(t * M_PI / 2.0);
+
+        Keyframe key;
+        key.Time = t;
+        key.Pose.Position = QVector3D(0.05f * qSin(phase), 1.2f + 0.02f * qSin(2.0f * phase), 0.0f);
+        key.Pose.Orientation = QQuaternion::fromEulerAngles(10.0f * qSin(2.0f * phase), 45.0f * qSin(phase), 0.0f);
+        m_poseScript.append(key);
+    }
+}
+
+VRPose VRSimBackend::headPoseAt(double time) const
+{
+    if (m_poseScript.size() == 1 || m_poseScript.last().Time <= 0.0)
+    {
+        return m_poseScript.first().Pose;
+    }
+
+    time = std::fmod(time, m_poseScript.last().Time);
+
+    int next = 1;
+    while (next < m_poseScript.size() - 1 && m_poseScript[next].Time < time)
+    {
+        ++next;
+    }
+
+    const Keyframe &a = m_poseScript[next - 1];
+    const Keyframe &b = m_poseScript[next];
+    const float t = qBound(0.0f, float((time - a.Time) / (b.Time - a.Time)), 1.0f);
+
+    VRPose pose;
+    pose.Position = a.Pose.Position + (b.Pose.Position - a.Pose.Position) * t;
+    pose.Orientation = QQuaternion::slerp(a.Pose.Orientation, b.Pose.Orientation, t);
+    return pose;
+}
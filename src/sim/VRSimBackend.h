@@ -0,0 +1,81 @@
+#ifndef VRSIMBACKEND_H
+#define VRSIMBACKEND_H
+
+#include "VRBackend.h"
+
+#include <QtCore/QVector>
+#include <QtGui/QOpenGLExtraFunctions>
+
+// A headset that does not exist. Eye buffers are plain offscreen textures,
+// the head follows a scripted pose track and "compositing" is a side by side
+// blit into the mirror texture, with the quad layers drawn over each eye.
+// Needs nothing past OpenGL 3.2 itself (the renderer needs 3.3 for
+// instancing), so the frame loop can be exercised on CI with Mesa's llvmpipe.
+//
+// Tunables (environment variables):
+//   QUICKVR_SIM_POSES        pose script, one "time x y z yaw pitch roll" per line
+//                            (seconds, meters, degrees). Loops at its last timestamp.
+//   QUICKVR_SIM_REFRESH_RATE simulated display refresh rate in Hz (default 90)
+//   QUICKVR_SIM_EYE_SIZE     eye buffer size as WIDTHxHEIGHT (default 1080x1200)
+//   QUICKVR_SIM_FRAMES       report ShouldQuit after that many frames (default: never)
+class VRSimBackend : public VRBackend, protected QOpenGLExtraFunctions
+{
+public:
+    struct Keyframe
+    {
+        double      Time;
+        VRPose      Pose;
+    };
+
+    VRSimBackend();
+    ~VRSimBackend() override;
+
+    const char *name() const override { return "sim"; }
+
+    bool initialize() override;
+    bool createSession() override;
+    void destroySession() override;
+
+    double refreshRate() const override { return m_refreshRate; }
+    QSize recommendedTextureSize(int eye) const override;
+    QMatrix4x4 projection(int eye, float zNear, float zFar) const override;
+
+    VRSessionStatus sessionStatus() override;
+    void recenter() override;
+    double predictedDisplayTime(long long frameIndex) const override;
+    void getEyePoses(long long frameIndex, VRPose eyePoses[2], double *sensorSampleTime) override;
+
+    VRSwapChain *createSwapChain(const QSize &size, bool withDepth) override;
+    bool submitFrame(long long frameIndex, const VREyeLayer &layer, const QVector<VRQuadLayer> &quads) override;
+
+    GLuint createMirrorTexture(const QSize &size, bool leftEyeOnly) override;
+    void destroyMirrorTexture() override;
+
+private:
+    bool loadPoseScript(const QString &fileName);
+    void buildDefaultPoseScript();
+    VRPose headPoseAt(double time) const;
+    void composeQuads(const VREyeLayer &layer, const QVector<VRQuadLayer> &quads, int eyeCount);
+    bool createQuadProgram();
+    void destroyQuadProgram();
+
+    bool m_session = false;
+    double m_refreshRate = 90.0;
+    QSize m_eyeSize = QSize(1080, 1200);
+    long long m_frameLimit = -1;
+    long long m_framesSubmitted = 0;
+    float m_ipd = 0.064f;
+    QVector<Keyframe> m_poseScript;
+
+    GLuint m_mirrorTexture = 0;
+    GLuint m_mirrorFBO = 0;
+    GLuint m_readFBO = 0;
+    QSize m_mirrorSize;
+    bool m_mirrorLeftEyeOnly = false;
+
+    GLuint m_quadProgram = 0;
+    GLuint m_quadVertexArray = 0;
+    GLint  m_quadTransformLocation = -1;
+};
+
+#endif // VRSIMBACKEND_H
@@ -1,6 +1,6 @@
 TEMPLATE = lib
 CONFIG += plugin qmltypes c++11
-QT += qml quick
+QT += qml quick concurrent
 
 QML_IMPORT_NAME = QuickVR
 QML_IMPORT_MAJOR_VERSION = 1
@@ -9,9 +9,12 @@ DESTDIR = imports/$$QML_IMPORT_NAME
 TARGET  = quickvrplugin
 QMLTYPES_FILENAME = $$DESTDIR/plugins.qmltypes
 
+INCLUDEPATH += \
+    sim
+
 _OVR_SDK_ROOT = $$(OVR_SDK_ROOT)
 isEmpty(_OVR_SDK_ROOT) {
-    error("OVR_SDK_ROOT" environment variable not set.)
+    message("OVR_SDK_ROOT" environment variable not set. Only the simulated HMD backend will be available.)
 } else {
     DEFINES += HAVE_LIBOVR
     INCLUDEPATH += \
@@ -27,21 +30,61 @@ isEmpty(_OVR_SDK_ROOT) {
     LIBS += -L$$_OVR_SDK_ROOT/LibOVR/Lib/Windows/$$_OVR_ARCH/$$_OVR_CONFIG/VS2017 -lLibOVR
 
     SOURCES += \
-        ovr/VRRenderer.cpp
+        ovr/VROvrBackend.cpp
 
     HEADERS += \
-        ovr/VRRenderer.h
+        ovr/VROvrBackend.h
 }
 
 SOURCES += \
         QuickVR_plugin.cpp \
+        VRBackend.cpp \
+        VRBox.cpp \
+        VRCulling.cpp \
+        VRFrameProfiler.cpp \
+        VRFrameStatistics.cpp \
+        VRGltfFile.cpp \
+        VRGltfImporter.cpp \
         VRHeadset.cpp \
-        VRWindow.cpp
+        VRKtxImage.cpp \
+        VRMaterial.cpp \
+        VRMeshFile.cpp \
+        VRMirror.cpp \
+        VRModel.cpp \
+        VRPanel.cpp \
+        VRRenderer.cpp \
+        VRResolutionScaler.cpp \
+        VRStats.cpp \
+        VRTextureLoader.cpp \
+        VRTransformHierarchy.cpp \
+        VRWindow.cpp \
+        sim/VRSimBackend.cpp
 
 HEADERS += \
         QuickVR_plugin.h \
+        VRBackend.h \
+        VRBox.h \
+        VRCulling.h \
+        VRFrameProfiler.h \
+        VRFrameStatistics.h \
+        VRGltfFile.h \
+        VRGltfImporter.h \
         VRHeadset.h \
-        VRWindow.h
+        VRKtxImage.h \
+        VRMaterial.h \
+        VRMeshFile.h \
+        VRMirror.h \
+        VRModel.h \
+        VRPanel.h \
+        VRPoseChannel.h \
+        VRRenderer.h \
+        VRResolutionScaler.h \
+        VRSimd.h \
+        VRStats.h \
+        VRTextureLoader.h \
+        VRTransformHierarchy.h \
+        VRWindow.h \
+        sim/VRSimBackend.h
 
 PLUGINFILES= \
     imports/$$QML_IMPORT_NAME/qmldir
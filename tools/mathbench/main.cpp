@@ -0,0 +1,163 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QVector>
+
+#include "VRCulling.h"
+#include "VRSimd.h"
+
+#include <cstdio>
+
+// Times the transform and culling math the renderer runs every frame, the
+// QMatrix4x4 code it replaced against VRSimd:
+//
+//   mathbench [iterations]
+//
+// Build in release mode, the numbers of a debug build mean nothing.
+namespace {
+
+const int kCount = 4096;
+
+QMatrix4x4 randomTransform(QRandomGenerator &random)
+{
+    QMatrix4x4 m;
+    m.translate(float(random.bounded(200.0) - 100.0), float(random.bounded(20.0)), float(random.bounded(200.0) - 100.0));
+    m.rotate(float(random.bounded(360.0)), QVector3D(float(random.bounded(1.0)), 1.0f, float(random.bounded(1.0))).normalized());
+    m.scale(float(0.5 + random.bounded(1.5)));
+    return m;
+}
+
+// What VRBounds::transformed() and VRFrustum did before: map all eight
+// corners, and test them against QVector4D planes.
+VRBounds mapCorners(const VRBounds &b, const QMatrix4x4 &m)
+{
+    VRBounds result;
+    for (int i = 0; i < 8; ++i)
+    {
+        const QVector3D corner(i & 1 ? b.Max.x() : b.Min.x(), i & 2 ? b.Max.y() : b.Min.y(), i & 4 ? b.Max.z() : b.Min.z());
+        result.expand(m.map(corner));
+    }
+    return result;
+}
+
+void extractPlanes(const QMatrix4x4 &m, QVector4D *planes)
+{
+    const QVector4D r0 = m.row(0), r1 = m.row(1), r2 = m.row(2), r3 = m.row(3);
+    planes[0] = r3 + r0;
+    planes[1] = r3 - r0;
+    planes[2] = r3 + r1;
+    planes[3] = r3 - r1;
+    planes[4] = r3 + r2;
+    planes[5] = r3 - r2;
+}
+
+bool intersectsPlanes(const QVector4D *planes, const VRBounds &b)
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        const QVector4D &p = planes[i];
+        const QVector3D positive(p.x() >= 0 ? b.Max.x() : b.Min.x(), p.y() >= 0 ? b.Max.y() : b.Min.y(), p.z() >= 0 ? b.Max.z() : b.Min.z());
+        if (QVector3D::dotProduct(p.toVector3D(), positive) + p.w() < 0)
+            return false;
+    }
+    return true;
+}
+
+template <typename Function>
+void run(const char *name, int iterations, Function function)
+{
+    QElapsedTimer timer;
+    timer.start();
+    int sink = 0;
+    for (int i = 0; i < iterations; ++i)
+        sink += function();
+    const qint64 ns = timer.nsecsElapsed();
+    printf("%-34s %8.2f ns per item  (%d)\n", name, double(ns) / (double(iterations) * kCount), sink);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = app.arguments();
+    const int iterations = args.size() > 1 ? qMax(1, args[1].toInt()) : 200;
+
+    QRandomGenerator random(1);
+    QVector<QMatrix4x4> transforms, products(kCount);
+    QVector<VRBounds> bounds, mapped(kCount);
+    for (int i = 0; i < kCount; ++i)
+    {
+        transforms.append(randomTransform(random));
+        VRBounds b;
+        b.expand(-QVector3D(float(random.bounded(1.0)), float(random.bounded(1.0)), float(random.bounded(1.0))));
+        b.expand(QVector3D(float(random.bounded(1.0)), float(random.bounded(1.0)), float(random.bounded(1.0))));
+        bounds.append(b);
+    }
+
+    QMatrix4x4 viewProj;
+    viewProj.perspective(90.0f, 1.0f, 0.1f, 1000.0f);
+    viewProj.lookAt(QVector3D(0, 1.7f, 0), QVector3D(0, 1.7f, -1), QVector3D(0, 1, 0));
+    const QMatrix4x4 parent = randomTransform(random);
+
+    run("QMatrix4x4 operator*", iterations, [&]() -> int {
+        for (int i = 0; i < kCount; ++i)
+            products[i] = parent * transforms[i];
+        return int(products[kCount - 1](0, 0));
+    });
+    run("VRSimd::multiply", iterations, [&]() -> int {
+        for (int i = 0; i < kCount; ++i)
+            products[i] = VRSimd::multiply(parent, transforms[i]);
+        return int(products[kCount - 1](0, 0));
+    });
+    run("VRSimd::multiply, batched", iterations, [&]() -> int {
+        VRSimd::multiply(parent, transforms.constData(), products.data(), kCount);
+        return int(products[kCount - 1](0, 0));
+    });
+
+    run("QMatrix4x4::lookAt", iterations, [&]() -> int {
+        for (int i = 0; i < kCount; ++i)
+        {
+            const QQuaternion q = QQuaternion::fromAxisAndAngle(0, 1, 0, float(i));
+            QMatrix4x4 view;
+            view.lookAt(QVector3D(0, 1.7f, 0), QVector3D(0, 1.7f, 0) + q.rotatedVector(QVector3D(0, 0, -1)), q.rotatedVector(QVector3D(0, 1, 0)));
+            products[i] = view;
+        }
+        return int(products[kCount - 1](0, 0));
+    });
+    run("VRSimd::viewMatrix", iterations, [&]() -> int {
+        for (int i = 0; i < kCount; ++i)
+            products[i] = VRSimd::viewMatrix(QQuaternion::fromAxisAndAngle(0, 1, 0, float(i)), QVector3D(0, 1.7f, 0));
+        return int(products[kCount - 1](0, 0));
+    });
+
+    run("Bounds, eight mapped corners", iterations, [&]() -> int {
+        for (int i = 0; i < kCount; ++i)
+            mapped[i] = mapCorners(bounds[i], transforms[i]);
+        return int(mapped[kCount - 1].Max.x());
+    });
+    run("VRBounds::transformed", iterations, [&]() -> int {
+        for (int i = 0; i < kCount; ++i)
+            mapped[i] = bounds[i].transformed(transforms[i]);
+        return int(mapped[kCount - 1].Max.x());
+    });
+
+    run("Frustum, QVector4D planes", iterations, [&]() -> int {
+        QVector4D planes[6];
+        extractPlanes(viewProj, planes);
+        int visible = 0;
+        for (int i = 0; i < kCount; ++i)
+            visible += intersectsPlanes(planes, mapped[i]);
+        return visible;
+    });
+    run("VRFrustum::intersects", iterations, [&]() -> int {
+        const VRFrustum frustum(viewProj);
+        int visible = 0;
+        for (int i = 0; i < kCount; ++i)
+            visible += frustum.intersects(mapped[i]);
+        return visible;
+    });
+
+    return 0;
+}
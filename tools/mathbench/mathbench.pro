@@ -0,0 +1,16 @@
+QT += core gui
+
+CONFIG += c++11 console release
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+        main.cpp \
+        ../../src/VRCulling.cpp
+
+HEADERS += \
+        ../../src/VRCulling.h \
+        ../../src/VRSimd.h
@@ -0,0 +1,110 @@
+#include "GltfReader.h"
+#include "MeshBuilder.h"
+
+#include "VRGltfFile.h"
+
+static void appendPrimitive(const VRGltfFile &gltf, const QJsonObject &primitive, const QMatrix4x4 &world, MeshBuilder &mesh)
+{
+    if (primitive.value(QLatin1String("mode")).toInt(4) != 4)
+    {
+        qWarning("Skipping a primitive that isn't a triangle list");
+        return;
+    }
+
+    const QJsonObject attributes = primitive.value(QLatin1String("attributes")).toObject();
+
+    int components = 0;
+    const QVector<float> positions = gltf.readFloats(attributes.value(QLatin1String("POSITION")).toInt(-1), &components);
+    if (components != 3)
+    {
+        qWarning("Skipping a primitive without positions");
+        return;
+    }
+    const int count = positions.size() / 3;
+
+    int uvComponents = 0;
+    const QVector<float> uvs = attributes.contains(QLatin1String("TEXCOORD_0"))
+            ? gltf.readFloats(attributes.value(QLatin1String("TEXCOORD_0")).toInt(), &uvComponents) : QVector<float>();
+    int colorComponents = 0;
+    const QVector<float> colors = attributes.contains(QLatin1String("COLOR_0"))
+            ? gltf.readFloats(attributes.value(QLatin1String("COLOR_0")).toInt(), &colorComponents) : QVector<float>();
+
+    float factor[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    const QJsonObject material = gltf.array("materials").at(primitive.value(QLatin1String("material")).toInt(-1)).toObject();
+    const QJsonArray baseColor = material.value(QLatin1String("pbrMetallicRoughness")).toObject().value(QLatin1String("baseColorFactor")).toArray();
+    for (int c = 0; c < 4 && c < baseColor.size(); ++c)
+        factor[c] = float(baseColor[c].toDouble());
+
+    if (uvs.size() < 2 * count)
+        uvComponents = 0;
+
+    const quint32 first = quint32(mesh.Vertices.size());
+    for (int i = 0; i < count; ++i)
+    {
+        const QVector3D pos = world.map(QVector3D(positions[3 * i], positions[3 * i + 1], positions[3 * i + 2]));
+
+        float color[4] = { factor[0], factor[1], factor[2], factor[3] };
+        if (colorComponents >= 3 && colors.size() >= colorComponents * count)
+        {
+            for (int c = 0; c < colorComponents; ++c)
+                color[c] *= colors[colorComponents * i + c];
+        }
+
+        VRMeshFileVertex v;
+        v.X = pos.x();
+        v.Y = pos.y();
+        v.Z = pos.z();
+        v.C = MeshBuilder::packLinearColor(color[0], color[1], color[2], color[3]);
+        // glTF texture coordinates start at the top left.
+        v.U = uvComponents == 2 ? uvs[2 * i] : 0.0f;
+        v.V = uvComponents == 2 ? 1.0f - uvs[2 * i + 1] : 0.0f;
+        mesh.Vertices.append(v);
+    }
+
+    if (primitive.contains(QLatin1String("indices")))
+    {
+        const QVector<quint32> indices = gltf.readIndices(primitive.value(QLatin1String("indices")).toInt());
+        for (quint32 index : indices)
+        {
+            if (index < quint32(count))
+                mesh.Indices.append(first + index);
+        }
+        mesh.Indices.resize(mesh.Indices.size() - mesh.Indices.size() % 3);
+    }
+    else
+    {
+        for (int i = 0; i + 2 < count; i += 3)
+            mesh.Indices << first + i << first + i + 1 << first + i + 2;
+    }
+}
+
+static void appendNode(const VRGltfFile &gltf, int index, const QMatrix4x4 &parent, MeshBuilder &mesh, int depth)
+{
+    const QJsonObject node = gltf.array("nodes").at(index).toObject();
+    if (node.isEmpty() || depth > 64)
+        return;
+
+    const QMatrix4x4 world = parent * VRGltfFile::localTransform(node);
+
+    if (node.contains(QLatin1String("mesh")))
+    {
+        const QJsonObject nodeMesh = gltf.array("meshes").at(node.value(QLatin1String("mesh")).toInt()).toObject();
+        for (const QJsonValue &primitive : nodeMesh.value(QLatin1String("primitives")).toArray())
+            appendPrimitive(gltf, primitive.toObject(), world, mesh);
+    }
+
+    for (const QJsonValue &child : node.value(QLatin1String("children")).toArray())
+        appendNode(gltf, child.toInt(), world, mesh, depth + 1);
+}
+
+bool readGltf(const QString &fileName, MeshBuilder &mesh, QString *error)
+{
+    VRGltfFile gltf;
+    if (!gltf.open(fileName, error))
+        return false;
+
+    for (int root : gltf.sceneRoots())
+        appendNode(gltf, root, QMatrix4x4(), mesh, 0);
+
+    return true;
+}
@@ -0,0 +1,13 @@
+#ifndef GLTFREADER_H
+#define GLTFREADER_H
+
+#include <QtCore/QString>
+
+struct MeshBuilder;
+
+// Every triangle primitive of the default scene of a .gltf or .glb,
+// flattened with its node transforms. Vertex colors are the material's base
+// color factor times COLOR_0, encoded to sRGB.
+bool readGltf(const QString &fileName, MeshBuilder &mesh, QString *error);
+
+#endif // GLTFREADER_H
@@ -0,0 +1,33 @@
+#ifndef MESHBUILDER_H
+#define MESHBUILDER_H
+
+#include <QtCore/QVector>
+
+#include "VRMeshFile.h"
+
+#include <cmath>
+
+// What the readers produce: one indexed triangle list in the renderer's
+// vertex layout, everything already in model space.
+struct MeshBuilder
+{
+    QVector<VRMeshFileVertex> Vertices;
+    QVector<quint32>          Indices;
+
+    // To the R, G, B, A byte order of VRMeshFileVertex::C.
+    static quint32 packColor(float r, float g, float b, float a)
+    {
+        const auto byte = [](float v) { return quint32(qBound(0.0f, v, 1.0f) * 255.0f + 0.5f); };
+        return byte(r) | (byte(g) << 8) | (byte(b) << 16) | (byte(a) << 24);
+    }
+
+    // Same for linear colors, whose R, G and B are encoded to the sRGB the
+    // renderer expects of vertex colors.
+    static quint32 packLinearColor(float r, float g, float b, float a)
+    {
+        const auto encode = [](float v) { return std::pow(qMax(v, 0.0f), 1.0f / 2.2f); };
+        return packColor(encode(r), encode(g), encode(b), a);
+    }
+};
+
+#endif // MESHBUILDER_H
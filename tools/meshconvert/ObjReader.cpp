@@ -0,0 +1,150 @@
+#include "ObjReader.h"
+#include "MeshBuilder.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QPair>
+
+namespace {
+
+struct Material
+{
+    float R = 1.0f, G = 1.0f, B = 1.0f, A = 1.0f;
+};
+
+QList<QByteArray> tokens(const QByteArray &line)
+{
+    return line.simplified().split(' ');
+}
+
+void readMtl(const QString &fileName, QHash<QByteArray, Material> &materials)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning("%s: %s", qPrintable(fileName), qPrintable(file.errorString()));
+        return;
+    }
+
+    Material *current = nullptr;
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    for (const QByteArray &line : lines)
+    {
+        const QList<QByteArray> t = tokens(line);
+        if (t[0] == "newmtl" && t.size() > 1)
+            current = &materials[t[1]];
+        else if (current && t[0] == "Kd" && t.size() > 3)
+            current->R = t[1].toFloat(), current->G = t[2].toFloat(), current->B = t[3].toFloat();
+        else if (current && t[0] == "d" && t.size() > 1)
+            current->A = t[1].toFloat();
+    }
+}
+
+// OBJ indices start at 1, negative ones count back from the latest element.
+int resolveIndex(const QByteArray &token, int count)
+{
+    bool ok = false;
+    const int index = token.toInt(&ok);
+    if (!ok || index == 0)
+        return -1;
+    const int resolved = index > 0 ? index - 1 : count + index;
+    return resolved < count ? resolved : -1;
+}
+
+} // namespace
+
+bool readObj(const QString &fileName, MeshBuilder &mesh, QString *error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        *error = file.errorString();
+        return false;
+    }
+
+    struct Position
+    {
+        float X, Y, Z;
+        float R, G, B;
+    };
+    QVector<Position> positions;
+    QVector<float> uvs;     // pairs
+
+    QHash<QByteArray, Material> materials;
+    Material material;
+
+    // Corners are shared when position, texture coordinate and color match.
+    QHash<QPair<quint64, quint32>, quint32> unique;
+
+    const QString directory = QFileInfo(fileName).absolutePath();
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    int lineNumber = 0;
+
+    for (const QByteArray &line : lines)
+    {
+        ++lineNumber;
+        const QList<QByteArray> t = tokens(line);
+
+        if (t[0] == "v" && t.size() > 3)
+        {
+            Position p = { t[1].toFloat(), t[2].toFloat(), t[3].toFloat(), 1.0f, 1.0f, 1.0f };
+            if (t.size() > 6)
+                p.R = t[4].toFloat(), p.G = t[5].toFloat(), p.B = t[6].toFloat();
+            positions.append(p);
+        }
+        else if (t[0] == "vt" && t.size() > 2)
+        {
+            uvs << t[1].toFloat() << t[2].toFloat();
+        }
+        else if (t[0] == "mtllib" && t.size() > 1)
+        {
+            readMtl(directory + QLatin1Char('/') + QString::fromUtf8(line.simplified().mid(7)), materials);
+        }
+        else if (t[0] == "usemtl" && t.size() > 1)
+        {
+            material = materials.value(t[1]);
+        }
+        else if (t[0] == "f" && t.size() > 3)
+        {
+            QVector<quint32> corners;
+            for (int i = 1; i < t.size(); ++i)
+            {
+                const QList<QByteArray> parts = t[i].split('/');
+                const int p = resolveIndex(parts[0], positions.size());
+                const int uv = parts.size() > 1 && !parts[1].isEmpty() ? resolveIndex(parts[1], uvs.size() / 2) : -1;
+                if (p < 0)
+                {
+                    *error = QStringLiteral("line %1: bad vertex index").arg(lineNumber);
+                    return false;
+                }
+
+                const Position &pos = positions[p];
+                const quint32 color = MeshBuilder::packColor(material.R * pos.R, material.G * pos.G, material.B * pos.B, material.A);
+                const QPair<quint64, quint32> key((quint64(p) << 32) | quint32(uv + 1), color);
+
+                auto it = unique.find(key);
+                if (it == unique.end())
+                {
+                    VRMeshFileVertex v;
+                    v.X = pos.X;
+                    v.Y = pos.Y;
+                    v.Z = pos.Z;
+                    v.C = color;
+                    v.U = uv >= 0 ? uvs[2 * uv] : 0.0f;
+                    v.V = uv >= 0 ? uvs[2 * uv + 1] : 0.0f;
+                    it = unique.insert(key, quint32(mesh.Vertices.size()));
+                    mesh.Vertices.append(v);
+                }
+                corners.append(it.value());
+            }
+
+            // Polygons as triangle fans
+            for (int i = 2; i < corners.size(); ++i)
+                mesh.Indices << corners[0] << corners[i - 1] << corners[i];
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,14 @@
+#ifndef OBJREADER_H
+#define OBJREADER_H
+
+#include <QtCore/QString>
+
+struct MeshBuilder;
+
+// Wavefront OBJ: positions (with the common "v x y z r g b" color
+// extension), texture coordinates and polygon faces. Vertex colors come from
+// the diffuse color (Kd, d) of the faces' material. Normals are ignored, the
+// renderer doesn't use them.
+bool readObj(const QString &fileName, MeshBuilder &mesh, QString *error);
+
+#endif // OBJREADER_H
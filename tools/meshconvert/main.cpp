@@ -0,0 +1,62 @@
+#include <QCoreApplication>
+#include <QFileInfo>
+
+#include "GltfReader.h"
+#include "MeshBuilder.h"
+#include "ObjReader.h"
+
+// Converts an OBJ, glTF or GLB file into a QuickVR binary mesh, meant to be
+// run offline so the headset only ever maps the result:
+//
+//   meshconvert venue.glb venue.qvrmesh
+//
+// and in QML:
+//
+//   VRModel { source: "venue.qvrmesh" }
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    const QStringList args = app.arguments();
+    if (args.size() != 3)
+    {
+        qWarning("usage: meshconvert <input.obj|.gltf|.glb> <output.qvrmesh>");
+        return 1;
+    }
+
+    const QString input = args[1];
+    const QString output = args[2];
+    const QString suffix = QFileInfo(input).suffix().toLower();
+
+    MeshBuilder mesh;
+    QString error;
+    bool ok;
+    if (suffix == QLatin1String("obj"))
+    {
+        ok = readObj(input, mesh, &error);
+    }
+    else if (suffix == QLatin1String("gltf") || suffix == QLatin1String("glb"))
+    {
+        ok = readGltf(input, mesh, &error);
+    }
+    else
+    {
+        qWarning("%s: unknown input format", qPrintable(input));
+        return 1;
+    }
+
+    if (!ok)
+    {
+        qWarning("%s: %s", qPrintable(input), qPrintable(error));
+        return 1;
+    }
+
+    if (!VRMeshFile::write(output, mesh.Vertices, mesh.Indices, &error))
+    {
+        qWarning("%s: %s", qPrintable(output), qPrintable(error));
+        return 1;
+    }
+
+    qDebug("%s: %d vertices, %d triangles", qPrintable(output), mesh.Vertices.size(), mesh.Indices.size() / 3);
+    return 0;
+}
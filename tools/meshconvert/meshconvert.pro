@@ -0,0 +1,27 @@
+QT += core gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += ../../src
+
+SOURCES += \
+        main.cpp \
+        ObjReader.cpp \
+        GltfReader.cpp \
+        ../../src/VRGltfFile.cpp \
+        ../../src/VRMeshFile.cpp
+
+HEADERS += \
+        MeshBuilder.h \
+        ObjReader.h \
+        GltfReader.h \
+        ../../src/VRGltfFile.h \
+        ../../src/VRMeshFile.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target